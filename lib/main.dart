@@ -1,8 +1,14 @@
 import 'package:flutter/material.dart';
+import 'package:flutter/services.dart';
+import 'dart:async';
 import 'dart:convert';
+import 'dart:typed_data';
 import 'package:http/http.dart' as http;
 import 'package:file_picker/file_picker.dart';
 import 'package:flutter_secure_storage/flutter_secure_storage.dart';
+import 'request_scheduler.dart';
+import 'scheduled_network_image.dart';
+import 'text_layout_cache.dart';
 
 void main() {
   runApp(const MainApp());
@@ -71,6 +77,36 @@ class _AuthWidgetState extends State<AuthWidget>
   String _statusMessage = "";
   String _token = "";
   late TabController _tabController;
+  final TextLayoutCache _layoutCache = TextLayoutCache();
+  // Row heights of each timeline as last shown.
+  final Map<String, _RowExtents> _rowExtents = {};
+  static const MethodChannel _memoryChannel =
+      MethodChannel('yarndesktopclient/memory');
+  static const MethodChannel _filterChannel =
+      MethodChannel('yarndesktopclient/filter');
+  static const MethodChannel _readStateChannel =
+      MethodChannel('yarndesktopclient/readstate');
+  final ValueNotifier<Map<String, int>> _unreadCounts = ValueNotifier({});
+  // Rows on screen since the last markRead call, per tab.
+  final Map<String, List<int>> _shownRows = {};
+  Timer? _markReadTimer;
+  static const MethodChannel _mentionsChannel =
+      MethodChannel('yarndesktopclient/mentions');
+  final FocusNode _statusFocusNode = FocusNode();
+  static const MethodChannel _cacheChannel =
+      MethodChannel('yarndesktopclient/cache');
+  // Key of the account's on-disk timeline cache and read state. The cache is
+  // shared with `--headless` runs.
+  String _account = '';
+  static const MethodChannel _transportChannel =
+      MethodChannel('yarndesktopclient/transport');
+  // Cleared when the runner has no native transport.
+  bool _nativeTransport = true;
+  int _nextStreamId = 0;
+  final Map<int, _TimelineStream> _timelineStreams = {};
+  // Timelines as fetched, before the mute list is applied.
+  final Map<String, List<dynamic>> _rawTimelines = {};
+  String _muteRules = '';
 
 @override
 void initState() {
@@ -81,6 +117,8 @@ void initState() {
 
   _tabController = TabController(length: 3, vsync: this);
   _tabController.addListener(_handleTabSelection);
+  _memoryChannel.setMethodCallHandler(_handleMemoryCall);
+  _transportChannel.setMethodCallHandler(_handleTransportCall);
 }
 
 Future<void> _initializeControllers() async {
@@ -90,12 +128,14 @@ Future<void> _initializeControllers() async {
   String? storedUsername = await storage.read(key: 'username');
   String? storedPassword = await storage.read(key: 'password');
   String? storedServerUrl = await storage.read(key: 'server');
+  String? storedMuteRules = await storage.read(key: 'mutes');
 
   setState(() {
     _usernameController.text = storedUsername ?? '';
     _passwordController.text = storedPassword ?? '';
     _serverUrlController.text = storedServerUrl ?? '';
   });
+  await _setMuteRules(storedMuteRules ?? '');
 }
 
 @override
@@ -104,11 +144,59 @@ void dispose() {
   _usernameController.dispose();
   _passwordController.dispose();
   _statusController.dispose();
+  _statusFocusNode.dispose();
   _tabController.removeListener(_handleTabSelection);
   _tabController.dispose();
+  _memoryChannel.setMethodCallHandler(null);
+  _transportChannel.setMethodCallHandler(null);
+  _markReadTimer?.cancel();
   super.dispose();
 }
 
+  // Called by the runner on memory pressure or when the window is hidden.
+  // Drops the requested cache tiers and returns the estimated bytes freed.
+  Future<int> _handleMemoryCall(MethodCall call) async {
+    if (call.method != 'trimMemory') {
+      throw MissingPluginException();
+    }
+    final List<dynamic> tiers = call.arguments['tiers'] ?? [];
+    int freed = 0;
+    if (tiers.contains('images')) {
+      final imageCache = PaintingBinding.instance.imageCache;
+      freed += imageCache.currentSizeBytes;
+      imageCache.clear();
+      imageCache.clearLiveImages();
+    }
+    if (tiers.contains('timelines')) {
+      // Tabs that are not on screen are refetched when selected again.
+      const endpoints = ['discover', 'timeline', 'mentions'];
+      for (int i = 0; i < endpoints.length; i++) {
+        final timeline = _timelineFor(endpoints[i]);
+        if (i != _tabController.index && timeline.value.isNotEmpty) {
+          freed += _estimateTimelineBytes(timeline.value);
+          timeline.value = [];
+          _rawTimelines.remove(endpoints[i]);
+          _rowExtents.remove(endpoints[i]);
+          freed += await _dropFilterPage(endpoints[i]);
+        }
+      }
+    }
+    if (tiers.contains('parse')) {
+      freed += _layoutCache.clear();
+      _rowExtents.clear();
+    }
+    return freed;
+  }
+
+  int _estimateTimelineBytes(List<dynamic> twts) {
+    int bytes = 0;
+    for (final twt in twts) {
+      // Strings are UTF-16 in memory, plus map and object overhead.
+      bytes += ((twt['text'] ?? '') as String).length * 2 + 512;
+    }
+    return bytes;
+  }
+
   void _handleTabSelection() async {
     if (_tabController.indexIsChanging) {
       return;
@@ -135,7 +223,7 @@ void dispose() {
     await storage.write(key: 'server', value: serverUrl);
 
     final String apiUrl = "$serverUrl/api/v1/auth";
-    final response = await http.post(
+    final response = await RequestScheduler.instance.post(
       Uri.parse(apiUrl),
       headers: {"Content-Type": "application/json"},
       body: jsonEncode({"username": username, "password": password}),
@@ -157,7 +245,7 @@ void dispose() {
 
   Future<String> whoAmI(String serverUrl, String tokenTemp) async {
     final String apiUrl = "$serverUrl/api/v1/whoami";
-    final response = await http.get(
+    final response = await RequestScheduler.instance.get(
       Uri.parse(apiUrl),
       headers: {
         "Content-Type": "application/json",
@@ -167,6 +255,9 @@ void dispose() {
 
     if (response.statusCode == 200) {
       final Map<String, dynamic> jsonResponse = jsonDecode(response.body);
+      if (jsonResponse['following'] is Map) {
+        _observeFollows(jsonResponse['following']);
+      }
       if (jsonResponse.containsKey('username')) {
         return jsonResponse['username'];
       } else {
@@ -178,20 +269,32 @@ void dispose() {
   }
 
   Future<List<dynamic>> getTimeline(
-      String serverUrl, String tokenTemp, String endpoint) async {
+      String serverUrl, String tokenTemp, String endpoint,
+      {RequestPriority priority = RequestPriority.userAction,
+      void Function(List<dynamic> firstTwts)? onFirstTwts}) async {
+    final streamed = await _getTimelineStreamed(
+        serverUrl, tokenTemp, endpoint, priority, onFirstTwts);
+    if (streamed != null) {
+      return streamed;
+    }
+
     final String apiUrl = "$serverUrl/api/v1/$endpoint";
-    final response = await http.post(
+    final response = await RequestScheduler.instance.post(
       Uri.parse(apiUrl),
       headers: {
         "Content-Type": "application/x-www-form-urlencoded",
         "token": tokenTemp,
       },
       body: '{}', // Sending an empty JSON object as the body
+      priority: priority,
+      // Only reads, so concurrent fetches of the timeline can share it.
+      coalesceKey: 'POST $apiUrl $tokenTemp',
     );
 
     if (response.statusCode == 200) {
       final Map<String, dynamic> jsonResponse = jsonDecode(response.body);
       if (jsonResponse.containsKey('twts')) {
+        _writeTimelineCache(endpoint, response.body);
         return jsonResponse['twts'];
       } else {
         throw Exception('twts not found in response.');
@@ -201,9 +304,71 @@ void dispose() {
     }
   }
 
+  // Fetches |endpoint| through the Linux runner, which asks for a compressed
+  // response, decompresses it on a worker thread and sends each twt over as
+  // soon as it has been received. The runner also updates the timeline
+  // cache. Returns null if the runner has no native transport.
+  Future<List<dynamic>?> _getTimelineStreamed(
+      String serverUrl,
+      String tokenTemp,
+      String endpoint,
+      RequestPriority priority,
+      void Function(List<dynamic> firstTwts)? onFirstTwts) async {
+    if (!_nativeTransport) {
+      return null;
+    }
+    try {
+      // A fetch of the same timeline that is still queued or running, e.g.
+      // from a tab switch, is shared; its callers all get the whole list.
+      return await RequestScheduler.instance
+          .run(Uri.parse("$serverUrl/api/v1/$endpoint"), (countBytes) async {
+        final id = _nextStreamId++;
+        final stream = _TimelineStream(onFirstTwts);
+        _timelineStreams[id] = stream;
+        try {
+          final result = await _transportChannel
+              .invokeMapMethod<String, dynamic>('fetchTimeline', {
+            'id': id,
+            'server': serverUrl,
+            'token': tokenTemp,
+            'endpoint': endpoint,
+            'account': _account,
+          });
+          countBytes(result?['wireBytes'] ?? 0);
+          stream.add(result?['twts'] ?? const []);
+          return stream.twts;
+        } finally {
+          _timelineStreams.remove(id);
+        }
+      }, priority: priority, coalesceKey: 'timeline $endpoint $tokenTemp');
+    } on MissingPluginException {
+      _nativeTransport = false;
+      return null;
+    } on PlatformException catch (e) {
+      throw Exception('Failed to load timeline: ${e.message}');
+    }
+  }
+
+  Future<dynamic> _handleTransportCall(MethodCall call) async {
+    if (call.method != 'timelineRows') {
+      throw MissingPluginException();
+    }
+    final stream = _timelineStreams[call.arguments['id']];
+    if (stream == null) {
+      return null;
+    }
+    stream.add(call.arguments['twts']);
+    final onFirstTwts = stream.onFirstTwts;
+    if (onFirstTwts != null) {
+      stream.onFirstTwts = null;
+      onFirstTwts(List.of(stream.twts));
+    }
+    return null;
+  }
+
   Future<void> postStatus(String token, String status, String serverUrl) async {
     final String apiUrl = "$serverUrl/api/v1/post";
-    final response = await http.post(
+    final response = await RequestScheduler.instance.post(
       Uri.parse(apiUrl),
       headers: {
         "Content-Type": "application/x-www-form-urlencoded",
@@ -215,9 +380,12 @@ void dispose() {
     if (response.statusCode != 200) {
       throw Exception('Failed to post status: ${response.reasonPhrase}');
     }
-    await _fetchTimeline('discover');
-    await _fetchTimeline('timeline');
-    await _fetchTimeline('mentions');
+    // _postStatus refreshes the user's own timeline right away; the others
+    // are refreshed behind it.
+    unawaited(
+        _fetchTimeline('discover', priority: RequestPriority.backgroundSync));
+    unawaited(
+        _fetchTimeline('mentions', priority: RequestPriority.backgroundSync));
   }
 
   Future<void> uploadMedia(String filePath, String token) async {
@@ -228,10 +396,10 @@ void dispose() {
     request.files
         .add(await http.MultipartFile.fromPath('media_file', filePath));
 
-    final response = await request.send();
+    final response = await RequestScheduler.instance.send(request);
 
     if (response.statusCode == 200) {
-      final responseBody = await response.stream.bytesToString();
+      final responseBody = response.body;
 
       final Map<String, dynamic> jsonResponse = jsonDecode(responseBody);
       final String mediaPath = jsonResponse['Path'];
@@ -243,39 +411,75 @@ void dispose() {
     }
   }
 
-List<Widget> parseStatusText(String text, String subjectToRemove) {
-    final userUrlRegex = RegExp(r'@<(\w+)\s+([^>]+?)>');
-
-    text = text.replaceAllMapped(userUrlRegex, (match) {
-      return '@${match.group(1)}';
-    });
-
-    final List<Widget> widgets = [];
-    final regex = RegExp(r'!\[[^\]]*\]\((.*?)\)');
+  static const double _rowPadding = 8.0;
+  static const double _avatarSize = 40.0;
+  static const double _replyHeight = 40.0;
+  static const double _dividerHeight = 16.0;
+  // Horizontal space taken by the row padding, avatar and gap to the text.
+  static const double _rowChromeWidth = 16.0 + _avatarSize + 16.0 + 16.0;
 
-    int lastMatchEnd = 0;
+  List<TwtSegment> parseStatusText(dynamic post, String subjectToRemove) {
+    return _layoutCache.parse(
+        _twtHash(post), post['text'] ?? '', subjectToRemove);
+  }
 
-    text = text.replaceAll(subjectToRemove, '');
-    final matches = regex.allMatches(text);
-    for (final match in matches) {
-      final imageUrl = match.group(1);
+  String _twtHash(dynamic post) {
+    return post['hash'] ?? '${(post['text'] ?? '').hashCode}';
+  }
 
-      if (lastMatchEnd < match.start) {
-        widgets.add(SelectableText(text.substring(lastMatchEnd, match.start)));
+  // Returns the height of the row for |post| from the cached layouts, and
+  // whether any of its text segments had to be estimated because they are
+  // not laid out yet.
+  (double, bool) _rowExtent(dynamic post, bool isLast, TextStyle textStyle,
+      TextStyle titleStyle, TextScaler scaler, double textWidth) {
+    final hash = _twtHash(post);
+    final segments = parseStatusText(post, post['subject'] ?? '');
+    bool estimated = false;
+    double extent = _rowPadding * 2 +
+        _titleHeight(titleStyle, scaler) +
+        _replyHeight +
+        (isLast ? 0 : _dividerHeight);
+    for (int i = 0; i < segments.length; i++) {
+      final segment = segments[i];
+      if (segment.isImage) {
+        extent += TextLayoutCache.imageHeight;
+        continue;
       }
-
-      if (imageUrl != null && imageUrl.isNotEmpty) {
-        widgets.add(Image.network(imageUrl));
+      final cached = _layoutCache.peek(hash, i, textStyle, scaler, textWidth);
+      if (cached != null) {
+        extent += cached.height;
+      } else {
+        estimated = true;
+        extent += _estimateTextHeight(segment.text!, textStyle, textWidth);
       }
-
-      lastMatchEnd = match.end;
     }
+    return (extent, estimated);
+  }
 
-    if (lastMatchEnd < text.length) {
-      widgets.add(SelectableText(text.substring(lastMatchEnd)));
+  // Queues the layout of the text segments of |post| between frames.
+  void _prefetchRow(
+      dynamic post, TextStyle textStyle, TextScaler scaler, double textWidth) {
+    final hash = _twtHash(post);
+    final segments = parseStatusText(post, post['subject'] ?? '');
+    for (int i = 0; i < segments.length; i++) {
+      if (!segments[i].isImage) {
+        _layoutCache.prefetch(
+            hash, i, segments[i].text!, textStyle, scaler, textWidth);
+      }
     }
+  }
 
-    return widgets;
+  double _titleHeight(TextStyle titleStyle, TextScaler scaler) {
+    return _layoutCache
+        .layout('\u0000title', 0, 'Ag', titleStyle, scaler, double.infinity)
+        .height;
+  }
+
+  double _estimateTextHeight(String text, TextStyle style, double width) {
+    final fontSize = style.fontSize ?? 14.0;
+    final charsPerLine = (width / (fontSize * 0.5)).floor().clamp(1, 1 << 20);
+    final lines = '\n'.allMatches(text).length + 1 + text.length ~/ charsPerLine;
+    return lines * fontSize * (style.height ?? 1.43);
   }
 
   void _fetchData() async {
@@ -294,6 +498,16 @@ List<Widget> parseStatusText(String text, String subjectToRemove) {
 
       _token = await getToken(username, password, serverUrl);
       String fetchedUsername = await whoAmI(serverUrl, _token);
+      _account = await _accountKey(username, serverUrl);
+      await _openReadState(_account);
+
+      // Show the cached timelines while the fresh ones load.
+      if (await _loadCachedTimelines()) {
+        setState(() {
+          _username = fetchedUsername;
+          _isLoggedIn = true;
+        });
+      }
 
       setState(() {
         _statusMessage = "Fetching timelines...";
@@ -318,14 +532,335 @@ List<Widget> parseStatusText(String text, String subjectToRemove) {
   }
 
   Future<void> _fetchAllTimelines(String serverUrl, String tokenTemp) async {
-    _discoverTimeline.value =
-        await getTimeline(serverUrl, tokenTemp, 'discover');
-    _userTimeline.value = await getTimeline(serverUrl, tokenTemp, 'timeline');
-    _mentionsTimeline.value =
-        await getTimeline(serverUrl, tokenTemp, 'mentions');
+    // Discover is the tab shown after login; the others are fetched
+    // alongside it at a lower priority. Their errors still surface when
+    // awaited below; ignore() only stops them being reported as uncaught if
+    // discover fails first.
+    final discover = getTimeline(serverUrl, tokenTemp, 'discover',
+        onFirstTwts: (twts) => _showFirstTwts('discover', twts));
+    final timeline = getTimeline(serverUrl, tokenTemp, 'timeline',
+        priority: RequestPriority.prefetch)
+      ..ignore();
+    final mentions = getTimeline(serverUrl, tokenTemp, 'mentions',
+        priority: RequestPriority.prefetch)
+      ..ignore();
+    await _setTimeline('discover', await discover);
+    await _setTimeline('timeline', await timeline);
+    await _setTimeline('mentions', await mentions);
+  }
+
+  Future<bool> _loadCachedTimelines() async {
+    bool loaded = false;
+    for (final endpoint in ['discover', 'timeline', 'mentions']) {
+      try {
+        final String? body = await _cacheChannel.invokeMethod<String>(
+            'readTimeline', {'account': _account, 'endpoint': endpoint});
+        if (body == null) {
+          continue;
+        }
+        final Map<String, dynamic> jsonResponse = jsonDecode(body);
+        if (jsonResponse['twts'] is List) {
+          await _setTimeline(endpoint, jsonResponse['twts']);
+          loaded = true;
+        }
+      } on MissingPluginException {
+        // Only the Linux runner has the on-disk cache.
+        return false;
+      } on FormatException {
+        // A truncated cache file is simply refetched.
+      }
+    }
+    return loaded;
+  }
+
+  void _writeTimelineCache(String endpoint, String body) {
+    _cacheChannel.invokeMethod('writeTimeline', {
+      'account': _account,
+      'endpoint': endpoint,
+      'body': body,
+    }).catchError((_) => null);
+  }
+
+  ValueNotifier<List<dynamic>> _timelineFor(String endpoint) {
+    switch (endpoint) {
+      case 'discover':
+        return _discoverTimeline;
+      case 'timeline':
+        return _userTimeline;
+      default:
+        return _mentionsTimeline;
+    }
+  }
+
+  // Shows the first part of a timeline that is still arriving, unless
+  // something is already shown. The part goes through the mute filter and
+  // becomes the tab's read-state rows like a whole timeline; only recording
+  // it for later re-filtering and indexing its mentions wait until
+  // _setTimeline has the whole timeline.
+  void _showFirstTwts(String endpoint, List<dynamic> twts) {
+    if (_timelineFor(endpoint).value.isEmpty) {
+      _setTimeline(endpoint, twts, partial: true);
+    }
+  }
+
+  // Runs a fetched timeline through the native mute filter once and shows
+  // the twts that are left.
+  Future<void> _setTimeline(String endpoint, List<dynamic> twts,
+      {bool partial = false}) async {
+    if (!partial) {
+      _rawTimelines[endpoint] = twts;
+      _observeMentions(twts);
+    }
+    await _filterTimeline(endpoint, twts);
+  }
+
+  // Ingests |twts| as the filter page of |endpoint| and shows those the mute
+  // list leaves visible.
+  Future<void> _filterTimeline(String endpoint, List<dynamic> twts) async {
+    List<dynamic> visible = twts;
+    try {
+      final Uint8List? bits =
+          await _filterChannel.invokeMethod<Uint8List>('ingestPage', {
+        'page': endpoint,
+        'twts': [
+          for (final twt in twts)
+            {
+              'text': twt['text'] ?? '',
+              'nick': twt['twter']['nick'] ?? '',
+              'uri': twt['twter']['uri'] ?? '',
+            },
+        ],
+      });
+      if (bits != null) {
+        visible = _applyVisibility(twts, bits);
+      }
+    } on MissingPluginException {
+      // Only the Linux runner has the native filter; show everything.
+    }
+    await _showTimeline(endpoint, visible);
+  }
+
+  // Feeds the authors and mentions of |twts| to the native completion index.
+  void _observeMentions(List<dynamic> twts) {
+    _mentionsChannel.invokeMethod('observe', {
+      'twts': [
+        for (final twt in twts)
+          {
+            'hash': twt['hash'] ?? '',
+            'nick': twt['twter']['nick'] ?? '',
+            'uri': twt['twter']['uri'] ?? '',
+            'text': twt['text'] ?? '',
+            'created': twt['created'] ?? '',
+          },
+      ],
+    }).catchError((_) => null);
+  }
+
+  void _observeFollows(Map<dynamic, dynamic> following) {
+    _mentionsChannel.invokeMethod('addFollows', {
+      'follows': {
+        for (final entry in following.entries)
+          if (entry.key is String && entry.value is String)
+            entry.key: entry.value,
+      },
+    }).catchError((_) => null);
+  }
+
+  // Completes the "@prefix" being typed before the cursor, if any. Each
+  // option carries the whole status text with the mention inserted.
+  Future<Iterable<_MentionOption>> _mentionOptions(
+      TextEditingValue value) async {
+    final selection = value.selection;
+    if (!selection.isCollapsed || selection.baseOffset < 0) {
+      return const [];
+    }
+    final before = value.text.substring(0, selection.baseOffset);
+    final match = RegExp(r'(^|\s)@([^\s@<>]+)$').firstMatch(before);
+    if (match == null) {
+      return const [];
+    }
+
+    List<dynamic>? completions;
+    try {
+      completions = await _mentionsChannel.invokeMethod<List<dynamic>>(
+          'complete', {'prefix': match.group(2), 'limit': 8});
+    } on MissingPluginException {
+      return const [];
+    }
+    final start = match.start + match.group(1)!.length;
+    final after = value.text.substring(selection.baseOffset);
+    return [
+      for (final completion in completions ?? [])
+        _MentionOption.insert(completion['nick'], completion['uri'],
+            before.substring(0, start), after),
+    ];
+  }
+
+  Future<void> _showTimeline(String endpoint, List<dynamic> twts) async {
+    _timelineFor(endpoint).value = twts;
+    _shownRows.remove(endpoint);
+    await _updateUnreadCounts('setTab', {
+      'tab': endpoint,
+      'hashes': [for (final twt in twts) _twtHash(twt)],
+    });
+  }
+
+  // Asks the runner for the account key, so the GUI and `--headless` runs
+  // normalize the server URL the same way.
+  Future<String> _accountKey(String username, String serverUrl) async {
+    try {
+      final key = await _cacheChannel.invokeMethod<String>(
+          'accountKey', {'username': username, 'server': serverUrl});
+      if (key != null) {
+        return key;
+      }
+    } on MissingPluginException {
+      // Only the Linux runner has the on-disk cache and read state.
+    }
+    return '$username@$serverUrl';
+  }
+
+  Future<void> _openReadState(String account) async {
+    try {
+      await _readStateChannel.invokeMethod('openAccount', {'account': account});
+    } on MissingPluginException {
+      // Only the Linux runner tracks read state.
+    }
+  }
+
+  Future<void> _updateUnreadCounts(String method, Object arguments) async {
+    try {
+      final counts = await _readStateChannel
+          .invokeMethod<Map<dynamic, dynamic>>(method, arguments);
+      if (counts != null) {
+        _unreadCounts.value = counts.cast<String, int>();
+      }
+    } on MissingPluginException {
+      // Only the Linux runner tracks read state.
+    }
+  }
+
+  // Records that rows |first| to |last| of |endpoint| were on screen, and
+  // marks the rows seen so far read shortly after.
+  void _noteRowsShown(String endpoint, int first, int last) {
+    final range = _shownRows[endpoint];
+    if (range == null) {
+      _shownRows[endpoint] = [first, last];
+    } else {
+      range[0] = first < range[0] ? first : range[0];
+      range[1] = last > range[1] ? last : range[1];
+    }
+    _markReadTimer ??= Timer(const Duration(milliseconds: 500), () {
+      _markReadTimer = null;
+      final shown = Map.of(_shownRows);
+      _shownRows.clear();
+      shown.forEach((tab, range) {
+        _updateUnreadCounts(
+            'markRead', {'tab': tab, 'first': range[0], 'last': range[1]});
+      });
+    });
+  }
+
+  List<dynamic> _applyVisibility(List<dynamic> twts, Uint8List bits) {
+    return [
+      for (int i = 0; i < twts.length && i < bits.length; i++)
+        if (bits[i] != 0) twts[i],
+    ];
+  }
+
+  Future<int> _dropFilterPage(String endpoint) async {
+    try {
+      return await _filterChannel
+              .invokeMethod<int>('dropPage', {'page': endpoint}) ??
+          0;
+    } on MissingPluginException {
+      return 0;
+    }
+  }
+
+  // Parses the mute list, one rule per line: "nick:<nick>", "feed:<uri>",
+  // "domain:<domain>", or else a word or phrase to hide.
+  Future<void> _setMuteRules(String rules) async {
+    _muteRules = rules;
+    final Map<String, List<String>> lists = {
+      'keywords': [],
+      'nicks': [],
+      'feeds': [],
+      'domains': [],
+    };
+    for (final line in rules.split('\n')) {
+      final rule = line.trim();
+      if (rule.startsWith('nick:')) {
+        lists['nicks']!.add(rule.substring(5).trim());
+      } else if (rule.startsWith('feed:')) {
+        lists['feeds']!.add(rule.substring(5).trim());
+      } else if (rule.startsWith('domain:')) {
+        lists['domains']!.add(rule.substring(7).trim());
+      } else if (rule.isNotEmpty) {
+        lists['keywords']!.add(rule);
+      }
+    }
+
+    try {
+      final Map<dynamic, dynamic>? pages =
+          await _filterChannel.invokeMethod<Map<dynamic, dynamic>>(
+              'setRules', lists);
+      pages?.forEach((endpoint, bits) {
+        final twts = _rawTimelines[endpoint];
+        if (twts != null) {
+          _showTimeline(endpoint, _applyVisibility(twts, bits));
+        }
+      });
+      // The runner drops its pages under memory pressure; filter those
+      // timelines again from scratch.
+      for (final entry in _rawTimelines.entries) {
+        if (pages == null || !pages.containsKey(entry.key)) {
+          await _filterTimeline(entry.key, entry.value);
+        }
+      }
+    } on MissingPluginException {
+      // Only the Linux runner has the native filter.
+    }
   }
 
-  Future<void> _fetchTimeline(String endpoint) async {
+  void _editMuteRules() async {
+    final controller = TextEditingController(text: _muteRules);
+    final String? rules = await showDialog<String>(
+      context: context,
+      builder: (context) => AlertDialog(
+        title: const Text('Mute list'),
+        content: TextField(
+          controller: controller,
+          decoration: const InputDecoration(
+            helperText: 'One per line: a word or phrase, nick:<nick>, '
+                'feed:<uri> or domain:<domain>',
+          ),
+          minLines: 5,
+          maxLines: 15,
+        ),
+        actions: [
+          TextButton(
+            onPressed: () => Navigator.of(context).pop(),
+            child: const Text('Cancel'),
+          ),
+          TextButton(
+            onPressed: () => Navigator.of(context).pop(controller.text),
+            child: const Text('Save'),
+          ),
+        ],
+      ),
+    );
+    controller.dispose();
+    if (rules == null) {
+      return;
+    }
+    const storage = FlutterSecureStorage();
+    await storage.write(key: 'mutes', value: rules);
+    await _setMuteRules(rules);
+  }
+
+  Future<void> _fetchTimeline(String endpoint,
+      {RequestPriority priority = RequestPriority.userAction}) async {
     setState(() {
       _isLoading = true;
       _statusMessage = "Refreshing $endpoint...";
@@ -333,19 +868,11 @@ List<Widget> parseStatusText(String text, String subjectToRemove) {
 
     try {
       String serverUrl = _serverUrlController.text.trim();
-      switch (endpoint) {
-        case 'discover':
-          _discoverTimeline.value =
-              await getTimeline(serverUrl, _token, endpoint);
-          break;
-        case 'timeline':
-          _userTimeline.value = await getTimeline(serverUrl, _token, endpoint);
-          break;
-        case 'mentions':
-          _mentionsTimeline.value =
-              await getTimeline(serverUrl, _token, endpoint);
-          break;
-      }
+      await _setTimeline(
+          endpoint,
+          await getTimeline(serverUrl, _token, endpoint,
+              priority: priority,
+              onFirstTwts: (twts) => _showFirstTwts(endpoint, twts)));
       setState(() {
         _statusMessage = "$endpoint refreshed successfully.";
       });
@@ -475,6 +1002,11 @@ void _replyToPost(String postHash, String postText, String postFeedUrl) {
                   style: const TextStyle(fontSize: 18),
                 ),
                 const Spacer(),
+                IconButton(
+                  icon: const Icon(Icons.filter_alt),
+                  tooltip: 'Mute list',
+                  onPressed: _editMuteRules,
+                ),
                 IconButton(
                   icon: const Icon(Icons.logout),
                   onPressed: () {
@@ -486,13 +1018,16 @@ void _replyToPost(String postHash, String postText, String postFeedUrl) {
               ],
             ),
             const SizedBox(height: 10),
-            TabBar(
-              controller: _tabController,
-              tabs: const [
-                Tab(text: 'Discover'),
-                Tab(text: 'Timeline'),
-                Tab(text: 'Mentions'),
-              ],
+            ValueListenableBuilder<Map<String, int>>(
+              valueListenable: _unreadCounts,
+              builder: (context, counts, child) => TabBar(
+                controller: _tabController,
+                tabs: [
+                  _buildTab('Discover', counts['discover'] ?? 0),
+                  _buildTab('Timeline', counts['timeline'] ?? 0),
+                  _buildTab('Mentions', counts['mentions'] ?? 0),
+                ],
+              ),
             ),
             Expanded(
               child: TabBarView(
@@ -504,13 +1039,50 @@ void _replyToPost(String postHash, String postText, String postFeedUrl) {
                 ],
               ),
             ),
-            TextField(
-              controller: _statusController,
-              decoration: const InputDecoration(
-                labelText: 'Post a status',
+            RawAutocomplete<_MentionOption>(
+              textEditingController: _statusController,
+              focusNode: _statusFocusNode,
+              optionsViewOpenDirection: OptionsViewOpenDirection.up,
+              optionsBuilder: _mentionOptions,
+              displayStringForOption: (option) => option.text,
+              onSelected: (option) {
+                _statusController.selection =
+                    TextSelection.collapsed(offset: option.cursor);
+              },
+              fieldViewBuilder:
+                  (context, controller, focusNode, onFieldSubmitted) =>
+                      TextField(
+                controller: controller,
+                focusNode: focusNode,
+                decoration: const InputDecoration(
+                  labelText: 'Post a status',
+                ),
+                minLines: 1,
+                maxLines: 5,
+              ),
+              optionsViewBuilder: (context, onSelected, options) => Align(
+                alignment: Alignment.bottomLeft,
+                child: Material(
+                  elevation: 4.0,
+                  child: ConstrainedBox(
+                    constraints:
+                        const BoxConstraints(maxHeight: 240, maxWidth: 480),
+                    child: ListView(
+                      shrinkWrap: true,
+                      padding: EdgeInsets.zero,
+                      children: [
+                        for (final option in options)
+                          ListTile(
+                            dense: true,
+                            title: Text('@${option.nick}'),
+                            subtitle: Text(option.uri),
+                            onTap: () => onSelected(option),
+                          ),
+                      ],
+                    ),
+                  ),
+                ),
               ),
-              minLines: 1,
-              maxLines: 5,
             ),
             Row(
               mainAxisAlignment: MainAxisAlignment.end,
@@ -531,56 +1103,310 @@ void _replyToPost(String postHash, String postText, String postFeedUrl) {
     }
   }
 
+  Widget _buildTab(String label, int unread) {
+    return Tab(
+      child: Badge(
+        isLabelVisible: unread > 0,
+        label: Text('$unread'),
+        child: Text(label),
+      ),
+    );
+  }
+
   Widget _buildTimeline(ValueNotifier<List<dynamic>> timeline) {
     return ValueListenableBuilder<List<dynamic>>(
       valueListenable: timeline,
       builder: (context, value, child) {
+        final endpoint = timeline == _discoverTimeline
+            ? 'discover'
+            : timeline == _userTimeline
+                ? 'timeline'
+                : 'mentions';
         if (value.isEmpty) {
           return const Center(child: Text("No posts available."));
         } else {
           return RefreshIndicator(
             onRefresh: () async {
-              await _fetchTimeline(timeline == _discoverTimeline
-                  ? 'discover'
-                  : timeline == _userTimeline
-                      ? 'timeline'
-                      : 'mentions');
+              await _fetchTimeline(endpoint);
             },
-            child: ListView.separated(
-              itemCount: value.length,
-              itemBuilder: (context, index) {
-                final post = value[index];
-                final username = post['twter']['nick'] ?? 'Unknown';
-                final avatarUrl = post['twter']['avatar'] ?? '';
-                final postSubject = post['subject'] ?? '';
-                final postFeedUrl = "${"${"@<" + username} " + post['twter']['uri']}>";
-
-                return ListTile(
-                  leading: CircleAvatar(
-                    backgroundImage:
-                        avatarUrl.isNotEmpty ? NetworkImage(avatarUrl) : null,
-                    child: avatarUrl.isEmpty
-                        ? Text(username[0].toUpperCase())
-                        : null,
-                  ),
-                  title: Text(username),
-                  subtitle: Column(
-                    crossAxisAlignment: CrossAxisAlignment.start,
-                    children: [
-                      ...parseStatusText(post['text'] ?? '', postSubject),
-                      IconButton(
-                        icon: const Icon(Icons.reply),
-                        onPressed: () => _replyToPost(postSubject, post['text'], postFeedUrl),
-                      ),
-                    ],
-                  ),
-                );
-              },
-              separatorBuilder: (context, index) => const Divider(),
+            child: LayoutBuilder(
+              builder: (context, constraints) => ValueListenableBuilder<int>(
+                valueListenable: _layoutCache.revision,
+                builder: (context, revision, child) =>
+                    _buildTimelineList(
+                        context, endpoint, value, constraints.maxWidth),
+              ),
             ),
           );
         }
       },
     );
   }
+
+  Widget _buildTimelineList(BuildContext context, String endpoint,
+      List<dynamic> value, double maxWidth) {
+    final theme = Theme.of(context);
+    final textStyle = theme.textTheme.bodyMedium!;
+    final titleStyle = theme.textTheme.titleMedium!;
+    final scaler = MediaQuery.textScalerOf(context);
+    final textWidth = TextLayoutCache.bucketWidth(maxWidth - _rowChromeWidth);
+    final layoutKey = '$textWidth/${TextLayoutCache.styleKey(textStyle, scaler)}'
+        '/${TextLayoutCache.styleKey(titleStyle, scaler)}';
+    var extents = _rowExtents[endpoint];
+    if (extents == null ||
+        !identical(extents.twts, value) ||
+        extents.layoutKey != layoutKey) {
+      extents = _rowExtents[endpoint] = _RowExtents(value, layoutKey);
+    }
+    extents.update(_layoutCache.revision.value);
+    final rows = extents;
+    (double, bool) rowExtent(int index) => _rowExtent(value[index],
+        index == value.length - 1, textStyle, titleStyle, scaler, textWidth);
+
+    final list = ListView.builder(
+      itemCount: value.length,
+      itemExtentBuilder: (index, dimensions) {
+        if (index >= value.length) {
+          return null;
+        }
+        return rows.extent(index, rowExtent);
+      },
+      itemBuilder: (context, index) {
+        final post = value[index];
+        final username = post['twter']['nick'] ?? 'Unknown';
+        final avatarUrl = post['twter']['avatar'] ?? '';
+        final postSubject = post['subject'] ?? '';
+        final postFeedUrl = "${"${"@<" + username} " + post['twter']['uri']}>";
+        final hash = _twtHash(post);
+        final segments = parseStatusText(post, postSubject);
+
+        // Lay out the rows just past the visible range ahead of time.
+        for (int next = index + 1;
+            next < value.length && next <= index + 10;
+            next++) {
+          if (!rows.isMeasured(next)) {
+            _prefetchRow(value[next], textStyle, scaler, textWidth);
+          }
+        }
+
+        // A row whose extent was estimated is built from the same estimates,
+        // so it fills its extent exactly until the list is rebuilt with the
+        // measured one.
+        rows.extent(index, rowExtent);
+        final estimated = !rows.isMeasured(index);
+        bool pending = false;
+        final children = <Widget>[
+          SizedBox(
+            height: _titleHeight(titleStyle, scaler),
+            child: Text(username,
+                style: titleStyle, maxLines: 1, overflow: TextOverflow.ellipsis),
+          ),
+        ];
+        for (int i = 0; i < segments.length; i++) {
+          final segment = segments[i];
+          if (segment.isImage) {
+            children.add(SizedBox(
+              height: TextLayoutCache.imageHeight,
+              child: Image(
+                  image: ScheduledNetworkImage(segment.imageUrl!),
+                  fit: BoxFit.contain,
+                  alignment: Alignment.centerLeft),
+            ));
+            continue;
+          }
+          final layout =
+              _layoutCache.peek(hash, i, textStyle, scaler, textWidth);
+          if (layout == null) {
+            pending = true;
+            _layoutCache.prefetch(
+                hash, i, segment.text!, textStyle, scaler, textWidth);
+          }
+          children.add(SizedBox(
+            height: layout == null || estimated
+                ? _estimateTextHeight(segment.text!, textStyle, textWidth)
+                : layout.height,
+            // Laid out exactly like the TextPainter that measured it: not
+            // merged with the ambient text style, and not editable text,
+            // which keeps room for a caret and can wrap differently.
+            child: Text(segment.text!,
+                style: textStyle.copyWith(inherit: false), textScaler: scaler),
+          ));
+        }
+        if (estimated && !pending) {
+          // Laid out since the extent was estimated, without a new revision.
+          _layoutCache.requestRebuild();
+        }
+        children.add(SizedBox(
+          height: _replyHeight,
+          child: IconButton(
+            padding: EdgeInsets.zero,
+            constraints: const BoxConstraints.tightFor(
+                width: _replyHeight, height: _replyHeight),
+            icon: const Icon(Icons.reply),
+            onPressed: () =>
+                _replyToPost(postSubject, post['text'], postFeedUrl),
+          ),
+        ));
+
+        return ClipRect(
+          child: Column(
+            children: [
+              Padding(
+                padding: const EdgeInsets.symmetric(
+                    horizontal: 16.0, vertical: _rowPadding),
+                child: Row(
+                  crossAxisAlignment: CrossAxisAlignment.start,
+                  children: [
+                    CircleAvatar(
+                      radius: _avatarSize / 2,
+                      backgroundImage: avatarUrl.isNotEmpty
+                          ? ScheduledNetworkImage(avatarUrl)
+                          : null,
+                      child: avatarUrl.isEmpty
+                          ? Text(username[0].toUpperCase())
+                          : null,
+                    ),
+                    const SizedBox(width: 16.0),
+                    SizedBox(
+                      width: textWidth,
+                      child: Column(
+                        crossAxisAlignment: CrossAxisAlignment.start,
+                        children: children,
+                      ),
+                    ),
+                  ],
+                ),
+              ),
+              if (index < value.length - 1)
+                const Divider(height: _dividerHeight),
+            ],
+          ),
+        );
+      },
+    );
+
+    // Rows are marked read once they have been inside the viewport; rows the
+    // list only builds ahead of it are not.
+    bool onMetrics(ScrollMetrics metrics) {
+      final (first, last) = rows.rangeIn(metrics.pixels,
+          metrics.pixels + metrics.viewportDimension, rowExtent);
+      if (first <= last) {
+        _noteRowsShown(endpoint, first, last);
+      }
+      return false;
+    }
+
+    return NotificationListener<ScrollMetricsNotification>(
+      onNotification: (notification) =>
+          notification.depth == 0 && onMetrics(notification.metrics),
+      child: NotificationListener<ScrollUpdateNotification>(
+        onNotification: (notification) =>
+            notification.depth == 0 && onMetrics(notification.metrics),
+        // Keeps the twt text selectable.
+        child: SelectionArea(child: list),
+      ),
+    );
+  }
+}
+
+/// A mention completion, with the status text as it reads once chosen.
+class _MentionOption {
+  final String nick;
+  final String uri;
+  final String text;
+  final int cursor;
+
+  const _MentionOption(this.nick, this.uri, this.text, this.cursor);
+
+  /// Replaces the "@prefix" between |before| and |after| with a full
+  /// "@<nick url>" mention, leaving the cursor just past it.
+  factory _MentionOption.insert(
+      String nick, String uri, String before, String after) {
+    final mention = '@<$nick $uri> ';
+    return _MentionOption(
+        nick, uri, before + mention + after, before.length + mention.length);
+  }
+}
+
+// Row heights of one timeline, so the list's extent lookups are cheap. Valid
+// for one list of twts, text width and set of styles; rows whose text had to
+// be estimated are recomputed once the layout cache has a new revision.
+class _RowExtents {
+  final List<dynamic> twts;
+  final String layoutKey;
+  final List<double?> _extents;
+  final Set<int> _estimated = {};
+  int _revision = -1;
+
+  _RowExtents(this.twts, this.layoutKey)
+      : _extents = List.filled(twts.length, null);
+
+  // Forgets the estimated rows if the layouts changed since the last call.
+  void update(int revision) {
+    if (revision == _revision) {
+      return;
+    }
+    _revision = revision;
+    for (final index in _estimated) {
+      _extents[index] = null;
+    }
+    _estimated.clear();
+  }
+
+  // Returns the extent of row |index|, from |compute| the first time.
+  double extent(int index, (double, bool) Function(int index) compute) {
+    final cached = _extents[index];
+    if (cached != null) {
+      return cached;
+    }
+    final (extent, estimated) = compute(index);
+    _extents[index] = extent;
+    if (estimated) {
+      _estimated.add(index);
+    }
+    return extent;
+  }
+
+  // Returns the first and last row overlapping the offsets |start| to |end|,
+  // or an empty range (first > last) if there is none.
+  (int, int) rangeIn(
+      double start, double end, (double, bool) Function(int index) compute) {
+    int first = 0;
+    double offset = 0;
+    while (first < twts.length) {
+      final next = offset + extent(first, compute);
+      if (next > start) {
+        break;
+      }
+      offset = next;
+      first++;
+    }
+    int last = first;
+    while (last < twts.length) {
+      offset += extent(last, compute);
+      if (offset >= end) {
+        break;
+      }
+      last++;
+    }
+    return (first, last < twts.length ? last : twts.length - 1);
+  }
+
+  // True if row |index| has an extent from measured layouts.
+  bool isMeasured(int index) =>
+      _extents[index] != null && !_estimated.contains(index);
+}
+
+// A timeline arriving from the native transport in batches of twts.
+class _TimelineStream {
+  final List<dynamic> twts = [];
+  void Function(List<dynamic> firstTwts)? onFirstTwts;
+
+  _TimelineStream(this.onFirstTwts);
+
+  void add(List<dynamic> rows) {
+    for (final row in rows) {
+      twts.add(jsonDecode(row as String));
+    }
+  }
 }
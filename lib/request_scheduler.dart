@@ -0,0 +1,383 @@
+import 'dart:async';
+import 'dart:collection';
+import 'dart:math';
+import 'dart:typed_data';
+
+import 'package:http/http.dart' as http;
+
+/// Priority classes, most urgent first.
+enum RequestPriority {
+  /// Something the user is waiting on: login, posting, a manual refresh.
+  userAction,
+
+  /// Content on screen, such as avatars and inline images.
+  visibleContent,
+
+  /// Content the user is likely to look at next.
+  prefetch,
+
+  /// Refreshes nobody is waiting for.
+  backgroundSync,
+}
+
+/// Limits for one priority class.
+class RequestClassLimits {
+  /// Requests of this class that may run at once.
+  final int concurrency;
+
+  /// Bytes per second shared by the uploads and downloads of this class, or
+  /// null for no cap.
+  final int? bytesPerSecond;
+
+  /// Whether the most recently queued request starts first. Suits content on
+  /// screen: the rows scrolled to last matter most, and older requests may be
+  /// for rows that have already scrolled away.
+  final bool newestFirst;
+
+  const RequestClassLimits(
+      {required this.concurrency,
+      this.bytesPerSecond,
+      this.newestFirst = false});
+}
+
+/// Counters for one priority class, see [RequestScheduler.stats].
+class RequestClassStats {
+  int queued = 0;
+  int active = 0;
+  int completed = 0;
+  int failed = 0;
+
+  /// Requests answered by an identical request already queued or running.
+  int coalesced = 0;
+  int bytes = 0;
+  Duration totalWait = Duration.zero;
+  Duration maxWait = Duration.zero;
+
+  Duration get averageWait => completed + failed == 0
+      ? Duration.zero
+      : totalWait ~/ (completed + failed);
+
+  Map<String, Object> toMap() => {
+        'queued': queued,
+        'active': active,
+        'completed': completed,
+        'failed': failed,
+        'coalesced': coalesced,
+        'bytes': bytes,
+        'averageWaitMs': averageWait.inMilliseconds,
+        'maxWaitMs': maxWait.inMilliseconds,
+      };
+}
+
+/// Runs every HTTP request of the app through per-class queues so that, for
+/// example, a burst of avatar loads or a large upload cannot hold up a
+/// timeline refresh the user asked for.
+///
+/// Requests are started in priority order subject to a limit per class, per
+/// host and overall. Within a class they start in queue order, or newest
+/// first for classes marked [RequestClassLimits.newestFirst]. One slot is
+/// always kept free for user actions. GETs for the same URL share one
+/// request, as do requests and tasks given the same coalesce key; if a more
+/// urgent caller joins a queued request, the request moves up to that
+/// caller's class.
+class RequestScheduler {
+  static final RequestScheduler instance = RequestScheduler();
+
+  final http.Client _client;
+  final Map<RequestPriority, RequestClassLimits> limits;
+  final int maxPerHost;
+  final int maxActive;
+
+  final Map<RequestPriority, Queue<_Job>> _queues = {
+    for (final priority in RequestPriority.values) priority: Queue<_Job>(),
+  };
+  final Map<RequestPriority, RequestClassStats> _stats = {
+    for (final priority in RequestPriority.values)
+      priority: RequestClassStats(),
+  };
+  final Map<RequestPriority, _TokenBucket> _buckets = {};
+  final Map<String, int> _activePerHost = {};
+  final Map<String, _Job> _coalescable = {};
+  int _active = 0;
+
+  RequestScheduler({
+    http.Client? client,
+    this.limits = const {
+      RequestPriority.userAction: RequestClassLimits(concurrency: 4),
+      RequestPriority.visibleContent:
+          RequestClassLimits(concurrency: 6, newestFirst: true),
+      RequestPriority.prefetch: RequestClassLimits(concurrency: 2),
+      RequestPriority.backgroundSync: RequestClassLimits(concurrency: 1),
+    },
+    this.maxPerHost = 6,
+    this.maxActive = 8,
+  }) : _client = client ?? http.Client() {
+    limits.forEach((priority, classLimits) {
+      final rate = classLimits.bytesPerSecond;
+      if (rate != null) {
+        _buckets[priority] = _TokenBucket(rate);
+      }
+    });
+  }
+
+  Future<http.Response> get(Uri url,
+      {Map<String, String>? headers,
+      RequestPriority priority = RequestPriority.userAction}) {
+    final request = http.Request('GET', url);
+    if (headers != null) {
+      request.headers.addAll(headers);
+    }
+    return send(request, priority: priority);
+  }
+
+  Future<http.Response> post(Uri url,
+      {Map<String, String>? headers,
+      String? body,
+      RequestPriority priority = RequestPriority.userAction,
+      String? coalesceKey}) {
+    final request = http.Request('POST', url);
+    if (headers != null) {
+      request.headers.addAll(headers);
+    }
+    if (body != null) {
+      request.body = body;
+    }
+    return send(request, priority: priority, coalesceKey: coalesceKey);
+  }
+
+  /// Queues |request| in |priority|'s class and completes with the full
+  /// response once it has run. Requests with the same |coalesceKey|, e.g.
+  /// POSTs that only read, share one response while the first is queued or
+  /// running; GETs are keyed by URL and token when no key is given.
+  Future<http.Response> send(http.BaseRequest request,
+      {RequestPriority priority = RequestPriority.userAction,
+      String? coalesceKey}) async {
+    final key = coalesceKey ?? _coalesceKey(request);
+    final response = await (_join(key, priority) ??
+        _enqueue(request.url, priority, key,
+            (job) => _transfer(request, job.priority)));
+    return response as http.Response;
+  }
+
+  /// Queues a transfer to |url| made by |task| rather than by the scheduler's
+  /// own client, e.g. on a native thread, so it still waits its turn and
+  /// counts towards the limits. |task| reports the bytes it transferred
+  /// through |countBytes|; bandwidth caps do not apply to it. Callers
+  /// passing the same |coalesceKey| while a task is queued or running get
+  /// that task's result instead of running their own.
+  Future<T> run<T>(
+      Uri url, Future<T> Function(void Function(int bytes) countBytes) task,
+      {RequestPriority priority = RequestPriority.userAction,
+      String? coalesceKey}) async {
+    final result = await (_join(coalesceKey, priority) ??
+        _enqueue(url, priority, coalesceKey,
+            (job) => task((bytes) => _stats[job.priority]!.bytes += bytes)));
+    return result as T;
+  }
+
+  /// A snapshot of the queue depth, wait times and traffic of every class.
+  Map<String, Map<String, Object>> stats() => {
+        for (final entry in _stats.entries) entry.key.name: entry.value.toMap(),
+      };
+
+  void close() => _client.close();
+
+  String? _coalesceKey(http.BaseRequest request) {
+    if (request.method != 'GET') {
+      return null;
+    }
+    // Requests made with different credentials must not share a response.
+    return '${request.url} ${request.headers['token'] ?? ''}';
+  }
+
+  // Returns the result of the job queued or running under |key|, moving it
+  // up to |priority| if that is more urgent, or null if there is none.
+  Future<Object?>? _join(String? key, RequestPriority priority) {
+    final existing = key == null ? null : _coalescable[key];
+    if (existing == null) {
+      return null;
+    }
+    _stats[priority]!.coalesced++;
+    if (priority.index < existing.priority.index) {
+      _promote(existing, priority);
+    }
+    return existing.completer.future;
+  }
+
+  Future<Object?> _enqueue(Uri url, RequestPriority priority, String? key,
+      Future<Object?> Function(_Job job) task) {
+    final job = _Job(url, priority, key, task);
+    if (key != null) {
+      _coalescable[key] = job;
+    }
+    _queues[priority]!.add(job);
+    _stats[priority]!.queued++;
+    _pump();
+    return job.completer.future;
+  }
+
+  void _promote(_Job job, RequestPriority priority) {
+    if (_queues[job.priority]!.remove(job)) {
+      _stats[job.priority]!.queued--;
+      job.priority = priority;
+      _queues[priority]!.add(job);
+      _stats[priority]!.queued++;
+      _pump();
+    }
+  }
+
+  void _pump() {
+    for (final priority in RequestPriority.values) {
+      final queue = _queues[priority]!;
+      final stats = _stats[priority]!;
+      final classLimits = limits[priority];
+      final limit = classLimits?.concurrency ?? 1;
+      // Everything but user actions leaves one slot free for them.
+      final reserved = priority == RequestPriority.userAction ? 0 : 1;
+      final blockedHosts = <String>{};
+      final jobs = queue.toList();
+      for (final job
+          in (classLimits?.newestFirst ?? false) ? jobs.reversed : jobs) {
+        if (stats.active >= limit || _active >= maxActive - reserved) {
+          break;
+        }
+        final host = job.url.host;
+        if (blockedHosts.contains(host) ||
+            (_activePerHost[host] ?? 0) >= maxPerHost) {
+          blockedHosts.add(host);
+          continue;
+        }
+        queue.remove(job);
+        stats.queued--;
+        _start(job);
+      }
+    }
+  }
+
+  Future<void> _start(_Job job) async {
+    final stats = _stats[job.priority]!;
+    final host = job.url.host;
+    final wait = DateTime.now().difference(job.enqueued);
+    stats.totalWait += wait;
+    stats.maxWait = wait > stats.maxWait ? wait : stats.maxWait;
+    stats.active++;
+    _active++;
+    _activePerHost[host] = (_activePerHost[host] ?? 0) + 1;
+
+    try {
+      final result = await job.task(job);
+      stats.completed++;
+      job.completer.complete(result);
+    } catch (error, stackTrace) {
+      stats.failed++;
+      job.completer.completeError(error, stackTrace);
+    } finally {
+      stats.active--;
+      _active--;
+      _activePerHost[host] = _activePerHost[host]! - 1;
+      if (job.key != null && _coalescable[job.key] == job) {
+        _coalescable.remove(job.key);
+      }
+      _pump();
+    }
+  }
+
+  Future<http.Response> _transfer(
+      http.BaseRequest request, RequestPriority priority) async {
+    final stats = _stats[priority]!;
+    final bucket = _buckets[priority];
+    final streamed = await _client.send(bucket == null
+        ? request
+        : _throttledRequest(request, bucket, stats));
+    final bytes = BytesBuilder(copy: false);
+    final body = bucket == null
+        ? streamed.stream
+        : _throttle(streamed.stream, bucket, stats);
+    await for (final chunk in body) {
+      bytes.add(chunk);
+    }
+    if (bucket == null) {
+      stats.bytes += bytes.length;
+    }
+    return http.Response.bytes(bytes.takeBytes(), streamed.statusCode,
+        request: streamed.request,
+        headers: streamed.headers,
+        isRedirect: streamed.isRedirect,
+        persistentConnection: streamed.persistentConnection,
+        reasonPhrase: streamed.reasonPhrase);
+  }
+
+  // Re-sends the body of |request| through |bucket|.
+  http.BaseRequest _throttledRequest(
+      http.BaseRequest request, _TokenBucket bucket, RequestClassStats stats) {
+    // Finalizing first, as multipart requests only set their content type
+    // then.
+    final body = request.finalize();
+    final throttled = http.StreamedRequest(request.method, request.url)
+      ..headers.addAll(request.headers)
+      ..contentLength = request.contentLength
+      ..followRedirects = request.followRedirects
+      ..maxRedirects = request.maxRedirects
+      ..persistentConnection = request.persistentConnection;
+    _throttle(body, bucket, stats).listen(throttled.sink.add,
+        onError: throttled.sink.addError, onDone: throttled.sink.close);
+    return throttled;
+  }
+
+  Stream<List<int>> _throttle(Stream<List<int>> source, _TokenBucket bucket,
+      RequestClassStats stats) async* {
+    await for (final chunk in source) {
+      for (int start = 0; start < chunk.length; start += _TokenBucket.slice) {
+        final end = min(start + _TokenBucket.slice, chunk.length);
+        await bucket.take(end - start);
+        stats.bytes += end - start;
+        yield chunk.sublist(start, end);
+      }
+    }
+  }
+}
+
+class _Job {
+  final Uri url;
+  final String? key;
+  final Future<Object?> Function(_Job job) task;
+  final DateTime enqueued = DateTime.now();
+  final Completer<Object?> completer = Completer();
+  RequestPriority priority;
+
+  _Job(this.url, this.priority, this.key, this.task);
+}
+
+/// Hands out bytes at a fixed rate, allowing bursts of up to one second.
+class _TokenBucket {
+  /// Largest number of bytes taken at once, so throttled streams are smooth.
+  static const int slice = 16 * 1024;
+
+  final int bytesPerSecond;
+  double _tokens;
+  DateTime _updated = DateTime.now();
+  Future<void> _tail = Future.value();
+
+  _TokenBucket(this.bytesPerSecond) : _tokens = bytesPerSecond.toDouble();
+
+  /// Completes once |bytes| may be transferred. Callers are served in order.
+  Future<void> take(int bytes) {
+    final result = _tail.then((_) => _take(bytes));
+    _tail = result;
+    return result;
+  }
+
+  Future<void> _take(int bytes) async {
+    final now = DateTime.now();
+    _tokens = min(
+        bytesPerSecond.toDouble(),
+        _tokens +
+            now.difference(_updated).inMicroseconds * bytesPerSecond / 1e6);
+    _updated = now;
+    _tokens -= bytes;
+    if (_tokens < 0) {
+      await Future.delayed(Duration(
+          microseconds: (-_tokens * 1e6 / bytesPerSecond).ceil()));
+    }
+  }
+}
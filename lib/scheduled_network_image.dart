@@ -0,0 +1,78 @@
+import 'dart:async';
+import 'dart:ui' as ui;
+
+import 'package:flutter/foundation.dart';
+import 'package:flutter/painting.dart';
+
+import 'request_scheduler.dart';
+
+/// Like [NetworkImage], but fetches through [RequestScheduler] so image loads
+/// queue behind what the user asked for and are capped per host. Visible
+/// content loads newest first, so images scrolled past do not hold up the
+/// ones now on screen.
+@immutable
+class ScheduledNetworkImage extends ImageProvider<ScheduledNetworkImage> {
+  final String url;
+  final double scale;
+  final RequestPriority priority;
+
+  const ScheduledNetworkImage(this.url,
+      {this.scale = 1.0, this.priority = RequestPriority.visibleContent});
+
+  @override
+  Future<ScheduledNetworkImage> obtainKey(ImageConfiguration configuration) {
+    return SynchronousFuture<ScheduledNetworkImage>(this);
+  }
+
+  @override
+  ImageStreamCompleter loadImage(
+      ScheduledNetworkImage key, ImageDecoderCallback decode) {
+    return MultiFrameImageStreamCompleter(
+      codec: _load(key, decode),
+      scale: key.scale,
+      debugLabel: key.url,
+      informationCollector: () => [
+        DiagnosticsProperty<ImageProvider>('Image provider', this),
+        DiagnosticsProperty<ScheduledNetworkImage>('Image key', key),
+      ],
+    );
+  }
+
+  Future<ui.Codec> _load(
+      ScheduledNetworkImage key, ImageDecoderCallback decode) async {
+    try {
+      final response = await RequestScheduler.instance
+          .get(Uri.parse(key.url), priority: key.priority);
+      if (response.statusCode != 200) {
+        throw NetworkImageLoadException(
+            statusCode: response.statusCode, uri: Uri.parse(key.url));
+      }
+      final bytes = response.bodyBytes;
+      if (bytes.isEmpty) {
+        throw Exception('ScheduledNetworkImage is an empty file: ${key.url}');
+      }
+      return await decode(await ui.ImmutableBuffer.fromUint8List(bytes));
+    } catch (e) {
+      // Let the image cache retry the next time the image is shown, whether
+      // the pod answered with an error or the connection failed.
+      scheduleMicrotask(() => PaintingBinding.instance.imageCache.evict(key));
+      rethrow;
+    }
+  }
+
+  // The priority only decides how soon the image is fetched; the same URL is
+  // the same image.
+  @override
+  bool operator ==(Object other) {
+    return other is ScheduledNetworkImage &&
+        other.url == url &&
+        other.scale == scale;
+  }
+
+  @override
+  int get hashCode => Object.hash(url, scale);
+
+  @override
+  String toString() =>
+      '${objectRuntimeType(this, 'ScheduledNetworkImage')}("$url", scale: $scale)';
+}
@@ -0,0 +1,224 @@
+import 'dart:collection';
+
+import 'package:flutter/scheduler.dart';
+import 'package:flutter/widgets.dart';
+
+/// A piece of a twt: either a run of text or an embedded image.
+class TwtSegment {
+  final String? text;
+  final String? imageUrl;
+
+  const TwtSegment.text(this.text) : imageUrl = null;
+  const TwtSegment.image(this.imageUrl) : text = null;
+
+  bool get isImage => imageUrl != null;
+}
+
+/// Measured layout of one text segment at a given width bucket and style.
+class TextLayoutEntry {
+  final double height;
+
+  /// Character offsets at which each line after the first starts.
+  final List<int> lineBreaks;
+
+  const TextLayoutEntry(this.height, this.lineBreaks);
+
+  int get estimatedBytes => 64 + lineBreaks.length * 8;
+}
+
+/// Caches parsed twt text and the measured height of every text segment so
+/// timeline rows are laid out once per width bucket, not on every rebuild.
+///
+/// Entries are keyed by twt hash, segment index, width bucket and the parts of
+/// the text style that affect layout. Colour is deliberately left out so a
+/// theme toggle reuses the existing layouts.
+class TextLayoutCache {
+  /// Widths are rounded down to a multiple of this, so small resizes reuse
+  /// the cached layouts. Text is laid out at exactly the bucketed width.
+  static const double widthBucket = 16.0;
+
+  /// Height reserved for each embedded image.
+  static const double imageHeight = 240.0;
+
+  final int maxEntries;
+
+  final LinkedHashMap<String, TextLayoutEntry> _layouts =
+      LinkedHashMap<String, TextLayoutEntry>();
+  final LinkedHashMap<String, List<TwtSegment>> _parsed =
+      LinkedHashMap<String, List<TwtSegment>>();
+  final LinkedHashMap<String, VoidCallback> _pending =
+      LinkedHashMap<String, VoidCallback>();
+  bool _taskScheduled = false;
+  bool _rebuildRequested = false;
+
+  /// Bumped whenever layouts computed between frames become available, so
+  /// lists using estimated extents can rebuild with the exact ones.
+  final ValueNotifier<int> revision = ValueNotifier(0);
+
+  TextLayoutCache({this.maxEntries = 20000});
+
+  static double bucketWidth(double width) {
+    final double bucketed = (width / widthBucket).floorToDouble() * widthBucket;
+    return bucketed < widthBucket ? widthBucket : bucketed;
+  }
+
+  /// Splits |text| into text and image segments, caching the result by
+  /// |hash|.
+  List<TwtSegment> parse(String hash, String text, String subjectToRemove) {
+    final cached = _parsed.remove(hash);
+    if (cached != null) {
+      _parsed[hash] = cached;
+      return cached;
+    }
+
+    final userUrlRegex = RegExp(r'@<(\w+)\s+([^>]+?)>');
+    text = text.replaceAllMapped(userUrlRegex, (match) {
+      return '@${match.group(1)}';
+    });
+    text = text.replaceAll(subjectToRemove, '');
+
+    final List<TwtSegment> segments = [];
+    final regex = RegExp(r'!\[[^\]]*\]\((.*?)\)');
+    int lastMatchEnd = 0;
+    for (final match in regex.allMatches(text)) {
+      final imageUrl = match.group(1);
+      if (lastMatchEnd < match.start) {
+        segments.add(TwtSegment.text(text.substring(lastMatchEnd, match.start)));
+      }
+      if (imageUrl != null && imageUrl.isNotEmpty) {
+        segments.add(TwtSegment.image(imageUrl));
+      }
+      lastMatchEnd = match.end;
+    }
+    if (lastMatchEnd < text.length) {
+      segments.add(TwtSegment.text(text.substring(lastMatchEnd)));
+    }
+
+    _parsed[hash] = segments;
+    if (_parsed.length > maxEntries) {
+      _parsed.remove(_parsed.keys.first);
+    }
+    return segments;
+  }
+
+  /// Returns the layout of |text|, measuring it if it is not cached yet.
+  TextLayoutEntry layout(String hash, int segment, String text,
+      TextStyle style, TextScaler scaler, double width) {
+    final key = _key(hash, segment, style, scaler, width);
+    final cached = _layouts.remove(key);
+    if (cached != null) {
+      _layouts[key] = cached;
+      return cached;
+    }
+    final entry = _measure(text, style, scaler, bucketWidth(width));
+    _layouts[key] = entry;
+    if (_layouts.length > maxEntries) {
+      _layouts.remove(_layouts.keys.first);
+    }
+    return entry;
+  }
+
+  /// Returns the cached layout of |text| or null without measuring.
+  TextLayoutEntry? peek(String hash, int segment, TextStyle style,
+      TextScaler scaler, double width) {
+    return _layouts[_key(hash, segment, style, scaler, width)];
+  }
+
+  /// Queues the layout of |text| to run between frames, if it is not cached
+  /// or queued already. Listeners of [revision] are notified once the queue
+  /// drains.
+  void prefetch(String hash, int segment, String text, TextStyle style,
+      TextScaler scaler, double width) {
+    final key = _key(hash, segment, style, scaler, width);
+    if (_layouts.containsKey(key)) {
+      return;
+    }
+    _pending.putIfAbsent(
+        key, () => () => layout(hash, segment, text, style, scaler, width));
+    if (_taskScheduled) {
+      return;
+    }
+    _taskScheduled = true;
+    SchedulerBinding.instance.scheduleTask(_runPending, Priority.idle);
+  }
+
+  /// Notifies listeners of [revision] after the current frame, e.g. because
+  /// something was built from estimates of layouts that are cached by now.
+  /// Does nothing if queued layouts will notify them anyway.
+  void requestRebuild() {
+    if (_taskScheduled || _rebuildRequested) {
+      return;
+    }
+    _rebuildRequested = true;
+    SchedulerBinding.instance.addPostFrameCallback((_) {
+      _rebuildRequested = false;
+      revision.value++;
+    });
+  }
+
+  /// Identifies the parts of |style| and |scaler| that affect layout.
+  /// Colour is left out, so a theme toggle keeps the cached layouts.
+  static String styleKey(TextStyle style, TextScaler scaler) {
+    return '${style.fontFamily}/${style.fontSize}/${style.fontWeight?.value}/'
+        '${style.fontStyle}/${style.height}/${style.letterSpacing}/'
+        '${style.wordSpacing}/${scaler.scale(14.0)}';
+  }
+
+  void _runPending() {
+    final stopwatch = Stopwatch()..start();
+    // Keep each task well inside a frame so scrolling stays smooth.
+    while (_pending.isNotEmpty && stopwatch.elapsedMicroseconds < 4000) {
+      _pending.remove(_pending.keys.first)!();
+    }
+    if (_pending.isNotEmpty) {
+      SchedulerBinding.instance.scheduleTask(_runPending, Priority.idle);
+    } else {
+      _taskScheduled = false;
+      revision.value++;
+    }
+  }
+
+  /// Drops every cached layout and parse result. Returns the estimated
+  /// number of bytes freed.
+  int clear() {
+    int bytes = 0;
+    for (final entry in _layouts.values) {
+      bytes += entry.estimatedBytes;
+    }
+    for (final segments in _parsed.values) {
+      for (final segment in segments) {
+        bytes += 32 + (segment.text?.length ?? 0) * 2 +
+            (segment.imageUrl?.length ?? 0) * 2;
+      }
+    }
+    _layouts.clear();
+    _parsed.clear();
+    _pending.clear();
+    return bytes;
+  }
+
+  String _key(String hash, int segment, TextStyle style, TextScaler scaler,
+      double width) {
+    return '$hash/$segment/${bucketWidth(width)}/${styleKey(style, scaler)}';
+  }
+
+  TextLayoutEntry _measure(
+      String text, TextStyle style, TextScaler scaler, double width) {
+    final painter = TextPainter(
+      text: TextSpan(text: text, style: style),
+      textDirection: TextDirection.ltr,
+      textScaler: scaler,
+    )..layout(maxWidth: width);
+
+    final List<int> lineBreaks = [];
+    final lines = painter.computeLineMetrics();
+    for (int i = 1; i < lines.length; i++) {
+      final position = painter.getPositionForOffset(
+          Offset(0, lines[i].baseline - lines[i].ascent / 2));
+      lineBreaks.add(position.offset);
+    }
+    final entry = TextLayoutEntry(painter.height, lineBreaks);
+    painter.dispose();
+    return entry;
+  }
+}
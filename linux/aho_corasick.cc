@@ -0,0 +1,112 @@
+#include "aho_corasick.h"
+
+#include <cstring>
+#include <deque>
+
+namespace {
+
+constexpr uint32_t kNoState = UINT32_MAX;
+
+uint8_t FoldCase(uint8_t byte) {
+  return (byte >= 'A' && byte <= 'Z') ? byte - 'A' + 'a' : byte;
+}
+
+}  // namespace
+
+AhoCorasick::AhoCorasick() : AhoCorasick(std::vector<std::string>()) {}
+
+AhoCorasick::AhoCorasick(const std::vector<std::string>& patterns) {
+  // Only bytes that occur in some pattern get their own class; everything
+  // else shares class 0, which keeps the table narrow.
+  memset(classes_, 0, sizeof(classes_));
+  uint8_t folded_class[256];
+  memset(folded_class, 0, sizeof(folded_class));
+  for (const std::string& pattern : patterns) {
+    for (char c : pattern) {
+      uint8_t folded = FoldCase(static_cast<uint8_t>(c));
+      if (folded_class[folded] == 0) {
+        folded_class[folded] = static_cast<uint8_t>(class_count_++);
+      }
+    }
+  }
+  for (int b = 0; b < 256; b++) {
+    classes_[b] = folded_class[FoldCase(static_cast<uint8_t>(b))];
+  }
+
+  // Build the trie.
+  transitions_.assign(class_count_, kNoState);
+  std::vector<std::vector<uint32_t>> state_outputs(1);
+  for (uint32_t index = 0; index < patterns.size(); index++) {
+    const std::string& pattern = patterns[index];
+    pattern_lengths_.push_back(pattern.size());
+    if (pattern.empty()) {
+      continue;
+    }
+    uint32_t state = 0;
+    for (char c : pattern) {
+      uint32_t& next =
+          transitions_[state * class_count_ + classes_[static_cast<uint8_t>(c)]];
+      if (next == kNoState) {
+        next = static_cast<uint32_t>(state_outputs.size());
+        state_outputs.emplace_back();
+        transitions_.resize(transitions_.size() + class_count_, kNoState);
+        // |next| may dangle after the resize, so fetch the new state again.
+        state = static_cast<uint32_t>(state_outputs.size() - 1);
+      } else {
+        state = next;
+      }
+    }
+    state_outputs[state].push_back(index);
+  }
+
+  // Resolve failure links breadth-first, turning the trie into a DFA.
+  const uint32_t state_count = static_cast<uint32_t>(state_outputs.size());
+  std::vector<uint32_t> fail(state_count, 0);
+  std::deque<uint32_t> queue;
+  for (uint32_t c = 0; c < class_count_; c++) {
+    uint32_t& next = transitions_[c];
+    if (next == kNoState) {
+      next = 0;
+    } else {
+      queue.push_back(next);
+    }
+  }
+  while (!queue.empty()) {
+    uint32_t state = queue.front();
+    queue.pop_front();
+    const std::vector<uint32_t>& inherited = state_outputs[fail[state]];
+    state_outputs[state].insert(state_outputs[state].end(), inherited.begin(),
+                                inherited.end());
+    for (uint32_t c = 0; c < class_count_; c++) {
+      uint32_t next = transitions_[state * class_count_ + c];
+      uint32_t fallback = transitions_[fail[state] * class_count_ + c];
+      if (next == kNoState) {
+        transitions_[state * class_count_ + c] = fallback;
+      } else {
+        fail[next] = fallback;
+        queue.push_back(next);
+      }
+    }
+  }
+
+  // Store row offsets instead of state numbers so the scan loop saves a
+  // multiply per byte, and tag states that have outputs.
+  for (uint32_t& next : transitions_) {
+    next = next * class_count_ |
+           (state_outputs[next].empty() ? 0 : kHasOutput);
+  }
+
+  output_offsets_.reserve(state_count + 1);
+  for (const std::vector<uint32_t>& outputs : state_outputs) {
+    output_offsets_.push_back(static_cast<uint32_t>(outputs_.size()));
+    outputs_.insert(outputs_.end(), outputs.begin(), outputs.end());
+  }
+  output_offsets_.push_back(static_cast<uint32_t>(outputs_.size()));
+}
+
+size_t AhoCorasick::memory_usage() const {
+  return sizeof(*this) + transitions_.capacity() * sizeof(uint32_t) +
+         output_offsets_.capacity() * sizeof(uint32_t) +
+         outputs_.capacity() * sizeof(uint32_t) +
+         pattern_lengths_.capacity() * sizeof(size_t);
+}
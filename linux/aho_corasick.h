@@ -0,0 +1,69 @@
+#ifndef FLUTTER_AHO_CORASICK_H_
+#define FLUTTER_AHO_CORASICK_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Multi-pattern matcher compiled into a dense DFA over byte equivalence
+// classes. Matching is ASCII case-insensitive; other bytes (including UTF-8
+// sequences) are compared as-is.
+class AhoCorasick {
+ public:
+  // Builds an automaton that reports |patterns| by their index. Empty
+  // patterns are ignored.
+  explicit AhoCorasick(const std::vector<std::string>& patterns);
+
+  AhoCorasick();
+
+  // Calls |on_match(pattern, end)| for every occurrence of a pattern in
+  // |text|, where |end| is the offset one past the last matched byte.
+  template <typename OnMatch>
+  void Scan(const std::string& text, OnMatch on_match) const {
+    if (pattern_lengths_.empty()) {
+      return;
+    }
+    const uint32_t* transitions = transitions_.data();
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(text.data());
+    uint32_t row = 0;
+    for (size_t i = 0; i < text.size(); i++) {
+      uint32_t next = transitions[row + classes_[data[i]]];
+      row = next & ~kHasOutput;
+      if (next & kHasOutput) {
+        uint32_t state = row / class_count_;
+        for (uint32_t o = output_offsets_[state];
+             o < output_offsets_[state + 1]; o++) {
+          on_match(outputs_[o], i + 1);
+        }
+      }
+    }
+  }
+
+  // Length in bytes of pattern |index|.
+  size_t pattern_length(uint32_t index) const {
+    return pattern_lengths_[index];
+  }
+
+  bool empty() const { return pattern_lengths_.empty(); }
+
+  // Approximate heap usage of the compiled automaton.
+  size_t memory_usage() const;
+
+ private:
+  // Set on transitions into states that report at least one pattern.
+  static constexpr uint32_t kHasOutput = 0x80000000u;
+
+  uint8_t classes_[256];
+  uint32_t class_count_ = 1;
+  // Row-major |state * class_count_ + class| table. Entries hold the start
+  // of the next state's row, tagged with |kHasOutput|.
+  std::vector<uint32_t> transitions_;
+  // Patterns ending at each state, including those reached through
+  // dictionary suffix links: outputs_[output_offsets_[s]..output_offsets_[s+1]).
+  std::vector<uint32_t> output_offsets_;
+  std::vector<uint32_t> outputs_;
+  std::vector<size_t> pattern_lengths_;
+};
+
+#endif  // FLUTTER_AHO_CORASICK_H_
@@ -0,0 +1,283 @@
+#include "headless.h"
+
+#include <glib.h>
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "json_reader.h"
+#include "sync_engine.h"
+#include "timeline_cache.h"
+#include "twt_stream.h"
+
+namespace {
+
+// Where the pod and credentials are read from unless given on the command
+// line. A [pod] group with server, username and password or password-file.
+std::string DefaultConfigPath() {
+  g_autofree gchar* path = g_build_filename(
+      g_get_user_config_dir(), "yarndesktopclient", "headless.ini", nullptr);
+  return path;
+}
+
+// Returns |value| with any trailing newline removed.
+std::string Chomp(std::string value) {
+  while (!value.empty() && (value.back() == '\n' || value.back() == '\r')) {
+    value.pop_back();
+  }
+  return value;
+}
+
+// Writes |twt|, the JSON of one twt, as one line with a "timeline" member
+// added so several timelines can share one stream.
+bool WriteNdjson(const std::string& endpoint, const char* twt, size_t size) {
+  if (size < 2 || twt[0] != '{') {
+    return false;
+  }
+  // JSON strings cannot hold raw newlines, so this only drops formatting.
+  std::string line = "{\"timeline\":\"" + endpoint + "\"";
+  for (size_t i = 1; i + 1 < size; i++) {
+    if (twt[i] != ' ' && twt[i] != '\t' && twt[i] != '\n' && twt[i] != '\r') {
+      line += ",";
+      break;
+    }
+  }
+  for (size_t i = 1; i < size; i++) {
+    if (twt[i] != '\n' && twt[i] != '\r') {
+      line += twt[i];
+    }
+  }
+  line += "\n";
+  return fwrite(line.data(), 1, line.size(), stdout) == line.size();
+}
+
+// Writes |twt| as "nick<TAB>uri<TAB>created<TAB>text", the twtxt registry
+// format. Newlines in the text become U+2028 as in twtxt files.
+bool WriteTwtxt(const char* twt, size_t size) {
+  JsonReader reader(twt, size);
+  std::string text, created, nick, uri;
+  bool ok = reader.ReadObject([&](const std::string& field) {
+    if (field == "text") {
+      return reader.ReadStringOrSkip(&text);
+    }
+    if (field == "created") {
+      return reader.ReadStringOrSkip(&created);
+    }
+    if (field != "twter") {
+      return reader.SkipValue();
+    }
+    return reader.ReadObject([&](const std::string& twter_field) {
+      if (twter_field == "nick") {
+        return reader.ReadStringOrSkip(&nick);
+      }
+      if (twter_field == "uri") {
+        return reader.ReadStringOrSkip(&uri);
+      }
+      return reader.SkipValue();
+    });
+  });
+  if (!ok) {
+    return false;
+  }
+  std::string line = nick + "\t" + uri + "\t" + created + "\t";
+  for (char c : text) {
+    if (c == '\n') {
+      line += "\xe2\x80\xa8";
+    } else if (c != '\r') {
+      line += c;
+    }
+  }
+  line += "\n";
+  return fwrite(line.data(), 1, line.size(), stdout) == line.size();
+}
+
+}  // namespace
+
+bool headless_requested(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--headless") == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int headless_run(int argc, char** argv) {
+  gboolean headless = FALSE;
+  gboolean offline = FALSE;
+  g_autofree gchar* config_path = nullptr;
+  g_autofree gchar* server = nullptr;
+  g_autofree gchar* username = nullptr;
+  g_autofree gchar* password_file = nullptr;
+  g_autofree gchar* format = nullptr;
+  g_auto(GStrv) timelines = nullptr;
+  GOptionEntry entries[] = {
+      {"headless", 0, 0, G_OPTION_ARG_NONE, &headless,
+       "Sync without starting the GUI", nullptr},
+      {"config", 0, 0, G_OPTION_ARG_FILENAME, &config_path,
+       "Pod configuration (default: ~/.config/yarndesktopclient/headless.ini)",
+       "FILE"},
+      {"server", 0, 0, G_OPTION_ARG_STRING, &server, "Pod URL", "URL"},
+      {"username", 0, 0, G_OPTION_ARG_STRING, &username, "Pod username",
+       "NAME"},
+      {"password-file", 0, 0, G_OPTION_ARG_FILENAME, &password_file,
+       "File holding the password (default: $YARN_PASSWORD)", "FILE"},
+      {"timeline", 0, 0, G_OPTION_ARG_STRING_ARRAY, &timelines,
+       "discover, timeline or mentions; repeatable (default: all)", "NAME"},
+      {"format", 0, 0, G_OPTION_ARG_STRING, &format,
+       "Write the timelines to stdout as ndjson or twtxt", "FORMAT"},
+      {"offline", 0, 0, G_OPTION_ARG_NONE, &offline,
+       "Only write the cached timelines, do not contact the pod", nullptr},
+      {nullptr, 0, 0, G_OPTION_ARG_NONE, nullptr, nullptr, nullptr},
+  };
+
+  g_autoptr(GOptionContext) context =
+      g_option_context_new("- sync yarn.social timelines without a GUI");
+  g_option_context_add_main_entries(context, entries, nullptr);
+  g_autoptr(GError) error = nullptr;
+  if (!g_option_context_parse(context, &argc, &argv, &error)) {
+    g_printerr("%s\n", error->message);
+    return 2;
+  }
+  std::string output = format != nullptr ? format : "";
+  if (!output.empty() && output != "ndjson" && output != "twtxt") {
+    g_printerr("Unknown format '%s', expected ndjson or twtxt\n",
+               output.c_str());
+    return 2;
+  }
+
+  // Command line options win over the configuration file.
+  std::string config = config_path != nullptr ? config_path : DefaultConfigPath();
+  g_autoptr(GKeyFile) key_file = g_key_file_new();
+  g_autoptr(GError) config_error = nullptr;
+  if (!g_key_file_load_from_file(key_file, config.c_str(), G_KEY_FILE_NONE,
+                                 &config_error) &&
+      !g_error_matches(config_error, G_FILE_ERROR, G_FILE_ERROR_NOENT)) {
+    g_printerr("Failed to read %s: %s\n", config.c_str(),
+               config_error->message);
+    return 2;
+  }
+  auto setting = [&](const gchar* option, const char* key) {
+    if (option != nullptr) {
+      return std::string(option);
+    }
+    g_autofree gchar* value =
+        g_key_file_get_string(key_file, "pod", key, nullptr);
+    return std::string(value != nullptr ? value : "");
+  };
+  std::string pod = setting(server, "server");
+  std::string user = setting(username, "username");
+  if (pod.empty() || user.empty()) {
+    g_printerr("No pod configured; pass --server and --username or create "
+               "%s\n", config.c_str());
+    return 2;
+  }
+
+  std::vector<std::string> endpoints;
+  for (gchar** name = timelines; name != nullptr && *name != nullptr; name++) {
+    if (!TimelineCache::IsValidEndpoint(*name)) {
+      g_printerr("Unknown timeline '%s'\n", *name);
+      return 2;
+    }
+    endpoints.push_back(*name);
+  }
+  if (endpoints.empty()) {
+    endpoints = {"discover", "timeline", "mentions"};
+  }
+
+  // Same account key as the GUI, so both share the cache.
+  TimelineCache cache(SyncEngine::AccountKey(user, pod));
+  int status = 0;
+  SyncEngine engine(pod);
+  bool logged_in = false;
+  if (!offline) {
+    std::string password = setting(password_file, "password-file");
+    std::string secret;
+    if (!password.empty()) {
+      g_autofree gchar* contents = nullptr;
+      g_autoptr(GError) read_error = nullptr;
+      if (!g_file_get_contents(password.c_str(), &contents, nullptr,
+                               &read_error)) {
+        g_printerr("Failed to read password: %s\n", read_error->message);
+        return 2;
+      }
+      secret = Chomp(contents);
+    } else if (g_getenv("YARN_PASSWORD") != nullptr) {
+      secret = g_getenv("YARN_PASSWORD");
+    } else {
+      secret = setting(nullptr, "password");
+    }
+
+    std::string login_error;
+    logged_in = engine.Login(user, secret, &login_error);
+    if (!logged_in) {
+      g_printerr("Failed to log in to %s: %s\n", pod.c_str(),
+                 login_error.c_str());
+      status = 1;
+    }
+  }
+
+  for (const std::string& endpoint : endpoints) {
+    // Twts are written out as they arrive and the response goes straight to
+    // the cache, so no timeline is held in memory as a whole.
+    bool written = true;
+    auto write_twt = [&](const char* twt, size_t size) {
+      if (written && !output.empty()) {
+        written = output == "ndjson" ? WriteNdjson(endpoint, twt, size)
+                                     : WriteTwtxt(twt, size);
+      }
+    };
+    TwtStream stream(write_twt);
+    bool fetched = false;
+    if (logged_in) {
+      std::unique_ptr<TimelineCache::Writer> writer = cache.BeginWrite(endpoint);
+      std::string fetch_error;
+      bool parsed = true;
+      fetched = engine.FetchTimeline(
+          endpoint,
+          [&](const char* data, size_t size) {
+            if (writer) {
+              writer->Append(data, size);
+            }
+            parsed = stream.Feed(data, size);
+            return parsed;
+          },
+          &fetch_error);
+      if (!parsed || (fetched && !stream.done())) {
+        fetched = false;
+        fetch_error = "Malformed timeline response.";
+      }
+      if (fetched && writer) {
+        writer->Commit();
+      } else if (!fetched) {
+        g_printerr("Failed to fetch %s: %s\n", endpoint.c_str(),
+                   fetch_error.c_str());
+        status = 1;
+      }
+    }
+    // Fall back to the cache when offline or the pod did not answer, unless
+    // part of the fresh timeline has been written already.
+    if (!output.empty() && !fetched && stream.twt_count() == 0) {
+      std::string body;
+      TwtStream cached(write_twt);
+      if (!cache.Read(endpoint, &body)) {
+        g_printerr("No cached %s timeline\n", endpoint.c_str());
+        status = 1;
+        continue;
+      }
+      if (!cached.Feed(body.data(), body.size()) || !cached.done()) {
+        g_printerr("Malformed %s timeline\n", endpoint.c_str());
+        status = 1;
+      }
+    }
+    if (!written) {
+      g_printerr("Failed to write the %s timeline\n", endpoint.c_str());
+      status = 1;
+    }
+  }
+  fflush(stdout);
+  return status;
+}
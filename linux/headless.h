@@ -0,0 +1,28 @@
+#ifndef FLUTTER_HEADLESS_H_
+#define FLUTTER_HEADLESS_H_
+
+/**
+ * headless_requested:
+ * @argc: the number of command line arguments.
+ * @argv: the command line arguments.
+ *
+ * Checks whether the runner was started with --headless.
+ *
+ * Returns: %TRUE if the GUI should not be started.
+ */
+bool headless_requested(int argc, char** argv);
+
+/**
+ * headless_run:
+ * @argc: the number of command line arguments.
+ * @argv: the command line arguments.
+ *
+ * Syncs the configured pod's timelines into the on-disk cache without
+ * creating any GTK window or Flutter engine, and optionally writes them to
+ * stdout as NDJSON or twtxt. See `--headless --help` for the options.
+ *
+ * Returns: the process exit status.
+ */
+int headless_run(int argc, char** argv);
+
+#endif  // FLUTTER_HEADLESS_H_
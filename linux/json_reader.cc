@@ -0,0 +1,263 @@
+#include "json_reader.h"
+
+#include <cstring>
+
+namespace {
+
+// Maximum nesting depth accepted by SkipValue().
+constexpr int kMaxDepth = 256;
+
+void AppendUtf8(std::string* out, unsigned code_point) {
+  if (code_point < 0x80) {
+    out->push_back(static_cast<char>(code_point));
+  } else if (code_point < 0x800) {
+    out->push_back(static_cast<char>(0xc0 | (code_point >> 6)));
+    out->push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+  } else if (code_point < 0x10000) {
+    out->push_back(static_cast<char>(0xe0 | (code_point >> 12)));
+    out->push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3f)));
+    out->push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+  } else {
+    out->push_back(static_cast<char>(0xf0 | (code_point >> 18)));
+    out->push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3f)));
+    out->push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3f)));
+    out->push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+  }
+}
+
+}  // namespace
+
+JsonReader::JsonReader(const char* data, size_t size)
+    : cursor_(data), end_(data + size) {}
+
+JsonReader::JsonReader(const std::string& document)
+    : JsonReader(document.data(), document.size()) {}
+
+bool JsonReader::ReadString(std::string* out) {
+  out->clear();
+  if (!Consume('"')) {
+    return false;
+  }
+  while (cursor_ < end_) {
+    // Copy the run up to the next quote or escape in one go.
+    const char* run = cursor_;
+    while (cursor_ < end_ && *cursor_ != '"' && *cursor_ != '\\') {
+      cursor_++;
+    }
+    out->append(run, cursor_ - run);
+    if (cursor_ >= end_) {
+      return false;
+    }
+    if (*cursor_++ == '"') {
+      return true;
+    }
+    if (cursor_ >= end_) {
+      return false;
+    }
+    char escape = *cursor_++;
+    switch (escape) {
+      case '"':
+      case '\\':
+      case '/':
+        out->push_back(escape);
+        break;
+      case 'b':
+        out->push_back('\b');
+        break;
+      case 'f':
+        out->push_back('\f');
+        break;
+      case 'n':
+        out->push_back('\n');
+        break;
+      case 'r':
+        out->push_back('\r');
+        break;
+      case 't':
+        out->push_back('\t');
+        break;
+      case 'u': {
+        unsigned code_point = 0;
+        if (!ReadHex4(&code_point)) {
+          return false;
+        }
+        // Combine UTF-16 surrogate pairs.
+        if (code_point >= 0xd800 && code_point < 0xdc00 && end_ - cursor_ >= 6 &&
+            cursor_[0] == '\\' && cursor_[1] == 'u') {
+          cursor_ += 2;
+          unsigned low = 0;
+          if (!ReadHex4(&low)) {
+            return false;
+          }
+          if (low >= 0xdc00 && low < 0xe000) {
+            code_point = 0x10000 + ((code_point - 0xd800) << 10) + (low - 0xdc00);
+          } else {
+            AppendUtf8(out, 0xfffd);
+            code_point = low;
+          }
+        }
+        if (code_point >= 0xd800 && code_point < 0xe000) {
+          code_point = 0xfffd;
+        }
+        AppendUtf8(out, code_point);
+        break;
+      }
+      default:
+        return false;
+    }
+  }
+  return false;
+}
+
+bool JsonReader::ReadStringOrSkip(std::string* out) {
+  out->clear();
+  SkipWhitespace();
+  if (cursor_ < end_ && *cursor_ == '"') {
+    return ReadString(out);
+  }
+  return SkipValue();
+}
+
+bool JsonReader::SkipValue() {
+  // Iterative so deeply nested input cannot overflow the stack.
+  int depth = 0;
+  do {
+    SkipWhitespace();
+    if (cursor_ >= end_) {
+      return false;
+    }
+    switch (*cursor_) {
+      case '{':
+      case '[':
+        if (++depth > kMaxDepth) {
+          return false;
+        }
+        cursor_++;
+        SkipWhitespace();
+        if (cursor_ < end_ && (*cursor_ == '}' || *cursor_ == ']')) {
+          // Empty container: treat it like a scalar.
+          cursor_++;
+          depth--;
+          break;
+        }
+        continue;
+      case '"': {
+        std::string ignored;
+        if (!ReadString(&ignored)) {
+          return false;
+        }
+        break;
+      }
+      case 't':
+        if (!SkipLiteral("true")) {
+          return false;
+        }
+        break;
+      case 'f':
+        if (!SkipLiteral("false")) {
+          return false;
+        }
+        break;
+      case 'n':
+        if (!SkipLiteral("null")) {
+          return false;
+        }
+        break;
+      default:
+        if (!SkipNumber()) {
+          return false;
+        }
+        break;
+    }
+    // After a scalar: an object key needs its value next, otherwise close
+    // any finished containers.
+    while (depth > 0) {
+      SkipWhitespace();
+      if (cursor_ >= end_) {
+        return false;
+      }
+      char c = *cursor_++;
+      if (c == ':' || c == ',') {
+        break;
+      }
+      if (c != '}' && c != ']') {
+        return false;
+      }
+      depth--;
+    }
+  } while (depth > 0);
+  return true;
+}
+
+bool JsonReader::ReadRaw(std::string* out) {
+  SkipWhitespace();
+  const char* start = cursor_;
+  if (!SkipValue()) {
+    return false;
+  }
+  out->assign(start, cursor_ - start);
+  return true;
+}
+
+bool JsonReader::AtEnd() {
+  SkipWhitespace();
+  return cursor_ >= end_;
+}
+
+void JsonReader::SkipWhitespace() {
+  while (cursor_ < end_ && (*cursor_ == ' ' || *cursor_ == '\t' ||
+                            *cursor_ == '\n' || *cursor_ == '\r')) {
+    cursor_++;
+  }
+}
+
+bool JsonReader::Consume(char c) {
+  SkipWhitespace();
+  if (cursor_ < end_ && *cursor_ == c) {
+    cursor_++;
+    return true;
+  }
+  return false;
+}
+
+bool JsonReader::SkipLiteral(const char* literal) {
+  size_t length = strlen(literal);
+  if (static_cast<size_t>(end_ - cursor_) < length ||
+      memcmp(cursor_, literal, length) != 0) {
+    return false;
+  }
+  cursor_ += length;
+  return true;
+}
+
+bool JsonReader::SkipNumber() {
+  const char* start = cursor_;
+  while (cursor_ < end_ &&
+         ((*cursor_ >= '0' && *cursor_ <= '9') || *cursor_ == '-' ||
+          *cursor_ == '+' || *cursor_ == '.' || *cursor_ == 'e' ||
+          *cursor_ == 'E')) {
+    cursor_++;
+  }
+  return cursor_ > start;
+}
+
+bool JsonReader::ReadHex4(unsigned* value) {
+  if (end_ - cursor_ < 4) {
+    return false;
+  }
+  *value = 0;
+  for (int i = 0; i < 4; i++) {
+    char c = *cursor_++;
+    *value <<= 4;
+    if (c >= '0' && c <= '9') {
+      *value |= c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      *value |= c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+      *value |= c - 'A' + 10;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
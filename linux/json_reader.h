@@ -0,0 +1,81 @@
+#ifndef FLUTTER_JSON_READER_H_
+#define FLUTTER_JSON_READER_H_
+
+#include <cstddef>
+#include <string>
+
+// A small pull parser over a JSON document held in memory. Values are read
+// in document order without building a tree; anything the caller is not
+// interested in is skipped.
+class JsonReader {
+ public:
+  JsonReader(const char* data, size_t size);
+  explicit JsonReader(const std::string& document);
+
+  // Reads the object at the cursor, calling |on_member(key)| for each
+  // member. The callback must consume the member's value with one of the
+  // Read*/Skip methods and return false to abort. Returns false on a syntax
+  // error or if the callback aborted.
+  template <typename OnMember>
+  bool ReadObject(OnMember on_member) {
+    if (!Consume('{')) {
+      return false;
+    }
+    if (Consume('}')) {
+      return true;
+    }
+    do {
+      std::string key;
+      if (!ReadString(&key) || !Consume(':') || !on_member(key)) {
+        return false;
+      }
+    } while (Consume(','));
+    return Consume('}');
+  }
+
+  // Reads the array at the cursor, calling |on_element()| for each element.
+  // The same rules as for ReadObject() apply to the callback.
+  template <typename OnElement>
+  bool ReadArray(OnElement on_element) {
+    if (!Consume('[')) {
+      return false;
+    }
+    if (Consume(']')) {
+      return true;
+    }
+    do {
+      if (!on_element()) {
+        return false;
+      }
+    } while (Consume(','));
+    return Consume(']');
+  }
+
+  // Reads a string, decoding escapes to UTF-8.
+  bool ReadString(std::string* out);
+
+  // Reads a string, or skips a value of any other type and leaves |out|
+  // empty.
+  bool ReadStringOrSkip(std::string* out);
+
+  // Skips the value at the cursor.
+  bool SkipValue();
+
+  // Skips the value at the cursor and sets |out| to its source text.
+  bool ReadRaw(std::string* out);
+
+  // True once only whitespace is left.
+  bool AtEnd();
+
+ private:
+  void SkipWhitespace();
+  bool Consume(char c);
+  bool SkipLiteral(const char* literal);
+  bool SkipNumber();
+  bool ReadHex4(unsigned* value);
+
+  const char* cursor_;
+  const char* end_;
+};
+
+#endif  // FLUTTER_JSON_READER_H_
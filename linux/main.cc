@@ -1,6 +1,17 @@
+#include <curl/curl.h>
+
+#include "headless.h"
 #include "my_application.h"
 
 int main(int argc, char** argv) {
+  // Before any thread exists; timelines are fetched on worker threads.
+  curl_global_init(CURL_GLOBAL_DEFAULT);
+
+  // Headless runs never touch GTK, so they start fast and stay small.
+  if (headless_requested(argc, argv)) {
+    return headless_run(argc, argv);
+  }
+
   g_autoptr(MyApplication) app = my_application_new();
   return g_application_run(G_APPLICATION(app), argc, argv);
 }
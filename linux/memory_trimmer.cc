@@ -0,0 +1,74 @@
+#include "memory_trimmer.h"
+
+#include <utility>
+
+const char* TrimTierName(TrimTier tier) {
+  switch (tier) {
+    case TrimTier::kImageCaches:
+      return "images";
+    case TrimTier::kColdTimelinePages:
+      return "timelines";
+    case TrimTier::kParseResults:
+      return "parse";
+  }
+  return "unknown";
+}
+
+const char* TrimLevelName(TrimLevel level) {
+  switch (level) {
+    case TrimLevel::kBackground:
+      return "background";
+    case TrimLevel::kLow:
+      return "low";
+    case TrimLevel::kMedium:
+      return "medium";
+    case TrimLevel::kCritical:
+      return "critical";
+  }
+  return "unknown";
+}
+
+MemoryTrimmer::MemoryTrimmer() = default;
+
+void MemoryTrimmer::Register(const std::string& name, TrimTier tier,
+                             TrimCallback callback) {
+  entries_.push_back(Entry{name, tier, std::move(callback)});
+}
+
+std::vector<TrimTier> MemoryTrimmer::TiersForLevel(TrimLevel level) {
+  switch (level) {
+    case TrimLevel::kBackground:
+    case TrimLevel::kLow:
+      return {TrimTier::kImageCaches};
+    case TrimLevel::kMedium:
+      return {TrimTier::kImageCaches, TrimTier::kColdTimelinePages};
+    case TrimLevel::kCritical:
+      return {TrimTier::kImageCaches, TrimTier::kColdTimelinePages,
+              TrimTier::kParseResults};
+  }
+  return {};
+}
+
+bool MemoryTrimmer::ShouldTrim(TrimLevel level, int64_t now_us) {
+  if (has_trimmed_ && level <= last_level_ &&
+      now_us - last_trim_us_ < kMinIntervalUs) {
+    return false;
+  }
+  has_trimmed_ = true;
+  last_level_ = level;
+  last_trim_us_ = now_us;
+  return true;
+}
+
+size_t MemoryTrimmer::TrimNative(TrimLevel level) {
+  size_t freed = 0;
+  for (TrimTier tier : TiersForLevel(level)) {
+    for (Entry& entry : entries_) {
+      if (entry.tier == tier) {
+        freed += entry.callback(level);
+      }
+    }
+  }
+  total_freed_ += freed;
+  return freed;
+}
@@ -0,0 +1,83 @@
+#ifndef FLUTTER_MEMORY_TRIMMER_H_
+#define FLUTTER_MEMORY_TRIMMER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// How hard the runner has been asked to shed memory, from the mildest signal
+// (window hidden) to the system being about to kill processes.
+enum class TrimLevel {
+  kBackground = 0,
+  kLow = 1,
+  kMedium = 2,
+  kCritical = 3,
+};
+
+// Groups of caches that are dropped together. Cheaper-to-rebuild tiers are
+// trimmed first; each level includes every tier of the levels below it.
+enum class TrimTier {
+  // Decoded images and avatars; refetched from the network cache on demand.
+  kImageCaches = 0,
+  // Timeline pages for tabs that are not on screen.
+  kColdTimelinePages = 1,
+  // Parsed twt text, layout results and similar derived data.
+  kParseResults = 2,
+};
+
+// Returns a stable, lower-case name for |tier|, as sent over the channel.
+const char* TrimTierName(TrimTier tier);
+
+// Returns a stable, lower-case name for |level|, used in log messages.
+const char* TrimLevelName(TrimLevel level);
+
+// Keeps track of the native caches that can be released under memory pressure
+// and decides which of them to drop for a given pressure level.
+class MemoryTrimmer {
+ public:
+  // Releases as much of a cache as it can and returns the bytes freed.
+  using TrimCallback = std::function<size_t(TrimLevel level)>;
+
+  MemoryTrimmer();
+
+  // Registers a native cache belonging to |tier| under |name|.
+  void Register(const std::string& name, TrimTier tier, TrimCallback callback);
+
+  // Returns the tiers that should be trimmed at |level|.
+  static std::vector<TrimTier> TiersForLevel(TrimLevel level);
+
+  // Returns true if a trim at |level| should run at |now_us| (monotonic
+  // microseconds). Repeated signals at the same or a lower level are
+  // coalesced for |kMinIntervalUs|, while an escalation always goes through.
+  bool ShouldTrim(TrimLevel level, int64_t now_us);
+
+  // Trims every registered native cache in the tiers for |level| and returns
+  // the total number of bytes freed.
+  size_t TrimNative(TrimLevel level);
+
+  // Total bytes freed by native and Dart-side caches since startup.
+  size_t total_freed() const { return total_freed_; }
+
+  // Adds |bytes| freed outside of the registered callbacks (e.g. by Dart) to
+  // the running total.
+  void AddFreed(size_t bytes) { total_freed_ += bytes; }
+
+  static constexpr int64_t kMinIntervalUs = 10 * 1000 * 1000;
+
+ private:
+  struct Entry {
+    std::string name;
+    TrimTier tier;
+    TrimCallback callback;
+  };
+
+  std::vector<Entry> entries_;
+  bool has_trimmed_ = false;
+  TrimLevel last_level_ = TrimLevel::kBackground;
+  int64_t last_trim_us_ = 0;
+  size_t total_freed_ = 0;
+};
+
+#endif  // FLUTTER_MEMORY_TRIMMER_H_
@@ -0,0 +1,311 @@
+#include "mention_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace {
+
+// Sighting weights are measured from here so they stay small numbers.
+constexpr double kEpochSeconds = 1577836800.0;  // 2020-01-01T00:00:00Z
+// A sighting counts half as much as one this much newer.
+constexpr double kHalfLifeSeconds = 14 * 24 * 60 * 60.0;
+
+std::string ToLower(std::string value) {
+  for (char& c : value) {
+    if (c >= 'A' && c <= 'Z') {
+      c = c - 'A' + 'a';
+    }
+  }
+  return value;
+}
+
+// Strips "scheme://" and a leading "www." from a lower-cased URI.
+std::string StripScheme(std::string uri) {
+  size_t scheme = uri.find("://");
+  if (scheme != std::string::npos) {
+    uri.erase(0, scheme + 3);
+  }
+  if (uri.compare(0, 4, "www.") == 0) {
+    uri.erase(0, 4);
+  }
+  return uri;
+}
+
+// log(exp(a) + exp(b)) without overflowing.
+double LogAddExp(double a, double b) {
+  double high = std::max(a, b);
+  return high + std::log1p(std::exp(std::min(a, b) - high));
+}
+
+size_t CommonPrefix(const std::string& label, const std::string& key,
+                    size_t pos) {
+  size_t length = 0;
+  while (length < label.size() && pos + length < key.size() &&
+         label[length] == key[pos + length]) {
+    length++;
+  }
+  return length;
+}
+
+}  // namespace
+
+MentionIndex::MentionIndex() : root_(new Node()) {}
+
+MentionIndex::~MentionIndex() = default;
+
+void MentionIndex::Observe(const std::string& nick, const std::string& uri,
+                           double time) {
+  if (uri.empty()) {
+    return;
+  }
+  double weight = (time - kEpochSeconds) / kHalfLifeSeconds * std::log(2.0);
+
+  auto found = entry_by_uri_.find(uri);
+  if (found == entry_by_uri_.end()) {
+    uint32_t id = static_cast<uint32_t>(entries_.size());
+    entries_.push_back(Entry{nick, uri, KeysFor(nick, uri), weight});
+    entry_by_uri_.emplace(uri, id);
+    for (const std::string& key : entries_[id].keys) {
+      Insert(key, id);
+    }
+    if (entries_.size() > kMaxEntries) {
+      // Prune a quarter at once so the rebuild is rare.
+      // The seen twts are kept, as the feeds dropped here rank lowest.
+      DropWorstEntries(kMaxEntries - kMaxEntries / 4);
+    }
+    return;
+  }
+
+  uint32_t id = found->second;
+  Entry& entry = entries_[id];
+  entry.score = LogAddExp(entry.score, weight);
+  if (!nick.empty() && nick != entry.nick) {
+    // Feeds can be renamed; keep completing the old nick too.
+    entry.nick = nick;
+    for (const std::string& key : KeysFor(nick, uri)) {
+      if (std::find(entry.keys.begin(), entry.keys.end(), key) ==
+          entry.keys.end()) {
+        entry.keys.push_back(key);
+        Insert(key, id);
+      }
+    }
+  }
+  for (const std::string& key : entry.keys) {
+    Promote(key, id);
+  }
+}
+
+void MentionIndex::AddFeed(const std::string& nick, const std::string& uri,
+                           double time) {
+  if (entry_by_uri_.find(uri) == entry_by_uri_.end()) {
+    Observe(nick, uri, time);
+  }
+}
+
+bool MentionIndex::MarkTwtSeen(const std::string& hash) {
+  auto inserted = seen_twts_.insert(hash);
+  if (!inserted.second) {
+    return false;
+  }
+  seen_order_.push_back(&*inserted.first);
+  if (seen_order_.size() > kMaxSeenTwts) {
+    seen_twts_.erase(*seen_order_.front());
+    seen_order_.pop_front();
+  }
+  return true;
+}
+
+std::vector<MentionIndex::Completion> MentionIndex::Complete(
+    const std::string& prefix, size_t limit) const {
+  std::string key = ToLower(prefix);
+  if (!key.empty() && key[0] == '@') {
+    key.erase(0, 1);
+  }
+  if (key.find("://") != std::string::npos) {
+    key = StripScheme(key);
+  }
+
+  const Node* node = root_.get();
+  size_t pos = 0;
+  while (pos < key.size()) {
+    auto it = std::lower_bound(
+        node->children.begin(), node->children.end(), key[pos],
+        [](const std::unique_ptr<Node>& child, char c) {
+          return child->label[0] < c;
+        });
+    if (it == node->children.end() || (*it)->label[0] != key[pos]) {
+      return {};
+    }
+    const Node* child = it->get();
+    size_t common = CommonPrefix(child->label, key, pos);
+    if (pos + common < key.size() && common < child->label.size()) {
+      return {};
+    }
+    pos += common;
+    node = child;
+  }
+
+  std::vector<Completion> completions;
+  for (uint32_t id : node->top) {
+    if (completions.size() >= limit) {
+      break;
+    }
+    completions.push_back(Completion{entries_[id].nick, entries_[id].uri});
+  }
+  return completions;
+}
+
+size_t MentionIndex::Prune(size_t max_entries) {
+  size_t before = memory_usage();
+  DropWorstEntries(max_entries);
+  // Otherwise the twts that introduced the dropped feeds would be skipped
+  // when their timelines are observed again.
+  seen_twts_.clear();
+  seen_order_.clear();
+  seen_order_.shrink_to_fit();
+  size_t after = memory_usage();
+  return before > after ? before - after : 0;
+}
+
+size_t MentionIndex::memory_usage() const {
+  size_t usage = NodeMemoryUsage(*root_);
+  for (const Entry& entry : entries_) {
+    usage += sizeof(entry) + entry.nick.capacity() + entry.uri.capacity();
+    for (const std::string& key : entry.keys) {
+      usage += sizeof(key) + key.capacity();
+    }
+  }
+  for (const std::string& hash : seen_twts_) {
+    usage += sizeof(hash) + sizeof(const std::string*) + 32 + hash.capacity();
+  }
+  return usage + entry_by_uri_.size() * (sizeof(std::string) + 32);
+}
+
+std::vector<std::string> MentionIndex::KeysFor(const std::string& nick,
+                                               const std::string& uri) {
+  std::vector<std::string> keys;
+  std::string nick_key = ToLower(nick);
+  if (!nick_key.empty()) {
+    keys.push_back(nick_key);
+  }
+  std::string uri_key = StripScheme(ToLower(uri));
+  if (!uri_key.empty() && uri_key != nick_key) {
+    keys.push_back(uri_key);
+  }
+  return keys;
+}
+
+void MentionIndex::DropWorstEntries(size_t max_entries) {
+  if (entries_.size() <= max_entries) {
+    return;
+  }
+  std::vector<Entry> kept = std::move(entries_);
+  std::nth_element(kept.begin(), kept.begin() + max_entries, kept.end(),
+                   [](const Entry& a, const Entry& b) {
+                     return a.score > b.score;
+                   });
+  kept.resize(max_entries);
+  kept.shrink_to_fit();
+
+  // Rebuild the tree; Offer() sorts each node's list whatever the order.
+  root_.reset(new Node());
+  entries_ = std::move(kept);
+  entry_by_uri_.clear();
+  for (uint32_t id = 0; id < entries_.size(); id++) {
+    entry_by_uri_.emplace(entries_[id].uri, id);
+    for (const std::string& key : entries_[id].keys) {
+      Insert(key, id);
+    }
+  }
+}
+
+void MentionIndex::Insert(const std::string& key, uint32_t entry) {
+  Node* node = root_.get();
+  Offer(node, entry);
+  size_t pos = 0;
+  while (pos < key.size()) {
+    auto it = std::lower_bound(
+        node->children.begin(), node->children.end(), key[pos],
+        [](const std::unique_ptr<Node>& child, char c) {
+          return child->label[0] < c;
+        });
+    if (it == node->children.end() || (*it)->label[0] != key[pos]) {
+      std::unique_ptr<Node> leaf(new Node());
+      leaf->label = key.substr(pos);
+      leaf->top.push_back(entry);
+      node->children.insert(it, std::move(leaf));
+      return;
+    }
+
+    Node* child = it->get();
+    size_t common = CommonPrefix(child->label, key, pos);
+    if (common < child->label.size()) {
+      // Split the edge; the new middle node starts with the child's list.
+      std::unique_ptr<Node> middle(new Node());
+      middle->label = child->label.substr(0, common);
+      middle->top = child->top;
+      child->label.erase(0, common);
+      middle->children.push_back(std::move(*it));
+      *it = std::move(middle);
+      child = it->get();
+    }
+    Offer(child, entry);
+    pos += common;
+    node = child;
+  }
+}
+
+void MentionIndex::Promote(const std::string& key, uint32_t entry) {
+  Node* node = root_.get();
+  Offer(node, entry);
+  size_t pos = 0;
+  while (pos < key.size()) {
+    auto it = std::lower_bound(
+        node->children.begin(), node->children.end(), key[pos],
+        [](const std::unique_ptr<Node>& child, char c) {
+          return child->label[0] < c;
+        });
+    if (it == node->children.end() || (*it)->label[0] != key[pos]) {
+      return;
+    }
+    node = it->get();
+    Offer(node, entry);
+    pos += node->label.size();
+  }
+}
+
+void MentionIndex::Offer(Node* node, uint32_t entry) {
+  std::vector<uint32_t>& top = node->top;
+  auto better = [this](uint32_t a, uint32_t b) {
+    return entries_[a].score > entries_[b].score ||
+           (entries_[a].score == entries_[b].score && a < b);
+  };
+
+  auto it = std::find(top.begin(), top.end(), entry);
+  if (it == top.end()) {
+    if (top.size() < kMaxCompletions) {
+      top.push_back(entry);
+    } else if (better(entry, top.back())) {
+      top.back() = entry;
+    } else {
+      return;
+    }
+    it = top.end() - 1;
+  }
+  // Scores only grow, so the entry can only move towards the front.
+  while (it != top.begin() && better(*it, *(it - 1))) {
+    std::iter_swap(it, it - 1);
+    --it;
+  }
+}
+
+size_t MentionIndex::NodeMemoryUsage(const Node& node) {
+  size_t usage = sizeof(node) + node.label.capacity() +
+                 node.children.capacity() * sizeof(node.children[0]) +
+                 node.top.capacity() * sizeof(uint32_t);
+  for (const auto& child : node.children) {
+    usage += NodeMemoryUsage(*child);
+  }
+  return usage;
+}
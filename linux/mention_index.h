@@ -0,0 +1,115 @@
+#ifndef FLUTTER_MENTION_INDEX_H_
+#define FLUTTER_MENTION_INDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Prefix index over every nick and feed URI the client has seen, used to
+// complete @mentions while composing.
+//
+// Keys live in a radix tree. Every node keeps the best few feeds of its
+// subtree, so a completion only walks the typed prefix. Feeds are ranked by
+// frecency: each sighting adds exp((time - epoch) / half-life) to a sum kept
+// in the log domain. That sum only ever grows, so the per-node lists can be
+// updated incrementally without ever re-sorting the whole index.
+class MentionIndex {
+ public:
+  struct Completion {
+    std::string nick;
+    std::string uri;
+  };
+
+  // How many completions each node remembers, and so the largest useful
+  // |limit| for Complete().
+  static constexpr size_t kMaxCompletions = 8;
+
+  // Past this many feeds the worst ranked quarter is pruned.
+  static constexpr size_t kMaxEntries = 20000;
+
+  // How many twt hashes MarkTwtSeen() remembers.
+  static constexpr size_t kMaxSeenTwts = 16384;
+
+  MentionIndex();
+  ~MentionIndex();
+
+  // Records that the feed |uri| with |nick| was seen at |time| (Unix
+  // seconds), either as a twt's author or as a mention in one.
+  void Observe(const std::string& nick, const std::string& uri, double time);
+
+  // Like Observe(), but leaves the rank of a feed that is indexed already
+  // alone. For follows, which are sent again on every login.
+  void AddFeed(const std::string& nick, const std::string& uri, double time);
+
+  // Returns false if the twt |hash| was marked before, so the sightings in
+  // a twt are not counted again when a timeline is refreshed. Only the most
+  // recent kMaxSeenTwts hashes are remembered.
+  bool MarkTwtSeen(const std::string& hash);
+
+  // Returns up to |limit| feeds whose nick or URI (without the scheme)
+  // starts with |prefix|, case-insensitively, best first.
+  std::vector<Completion> Complete(const std::string& prefix,
+                                   size_t limit) const;
+
+  // Keeps only the |max_entries| best ranked feeds and returns the
+  // approximate number of bytes freed. The twts marked seen are forgotten
+  // too, so the dropped feeds are learned again from timelines shown later.
+  size_t Prune(size_t max_entries);
+
+  // Number of distinct feeds indexed.
+  size_t size() const { return entries_.size(); }
+
+  // Approximate heap usage.
+  size_t memory_usage() const;
+
+ private:
+  struct Entry {
+    std::string nick;
+    std::string uri;
+    // Keys the entry is indexed under, see KeysFor().
+    std::vector<std::string> keys;
+    // log(sum(exp(sighting weight))), see the class comment.
+    double score;
+  };
+
+  struct Node {
+    // Bytes on the edge from the parent to this node.
+    std::string label;
+    // Sorted by the first byte of their labels.
+    std::vector<std::unique_ptr<Node>> children;
+    // Best entries of the subtree, best first, at most kMaxCompletions.
+    std::vector<uint32_t> top;
+  };
+
+  // The lower-cased nick and the URI without scheme or "www.".
+  static std::vector<std::string> KeysFor(const std::string& nick,
+                                          const std::string& uri);
+
+  // Inserts |key| for |entry|, splitting edges as needed, and offers the
+  // entry to the top list of every node on the way.
+  void Insert(const std::string& key, uint32_t entry);
+
+  // Offers |entry| to the top list of every node on the path of |key|.
+  void Promote(const std::string& key, uint32_t entry);
+
+  void Offer(Node* node, uint32_t entry);
+
+  // Keeps only the |max_entries| best ranked feeds and rebuilds the tree.
+  void DropWorstEntries(size_t max_entries);
+
+  static size_t NodeMemoryUsage(const Node& node);
+
+  std::unique_ptr<Node> root_;
+  std::vector<Entry> entries_;
+  std::unordered_map<std::string, uint32_t> entry_by_uri_;
+  std::unordered_set<std::string> seen_twts_;
+  // Points into seen_twts_, oldest first.
+  std::deque<const std::string*> seen_order_;
+};
+
+#endif  // FLUTTER_MENTION_INDEX_H_
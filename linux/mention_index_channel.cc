@@ -0,0 +1,153 @@
+#include "mention_index_channel.h"
+
+#include <cstring>
+#include <string>
+
+namespace {
+
+std::string LookupString(FlValue* map, const char* key) {
+  FlValue* value = fl_value_lookup_string(map, key);
+  if (value == nullptr || fl_value_get_type(value) != FL_VALUE_TYPE_STRING) {
+    return std::string();
+  }
+  return fl_value_get_string(value);
+}
+
+double NowSeconds() {
+  return g_get_real_time() / static_cast<double>(G_USEC_PER_SEC);
+}
+
+// Parses an RFC 3339 timestamp as sent by the pod, or returns |fallback|.
+double ParseTime(const std::string& created, double fallback) {
+  if (created.empty()) {
+    return fallback;
+  }
+  g_autoptr(GDateTime) time = g_date_time_new_from_iso8601(created.c_str(),
+                                                           nullptr);
+  if (time == nullptr) {
+    return fallback;
+  }
+  return g_date_time_to_unix(time) +
+         g_date_time_get_microsecond(time) / static_cast<double>(G_USEC_PER_SEC);
+}
+
+// Indexes every "@<nick url>" mention in |text|.
+void ObserveMentions(MentionIndex* index, const std::string& text,
+                     double time) {
+  size_t pos = 0;
+  while ((pos = text.find("@<", pos)) != std::string::npos) {
+    pos += 2;
+    size_t close = text.find('>', pos);
+    if (close == std::string::npos) {
+      return;
+    }
+    std::string mention = text.substr(pos, close - pos);
+    size_t space = mention.find(' ');
+    if (space != std::string::npos && space > 0) {
+      index->Observe(mention.substr(0, space), mention.substr(space + 1), time);
+    }
+    pos = close + 1;
+  }
+}
+
+FlMethodResponse* Observe(MentionIndex* index, FlValue* args) {
+  FlValue* list = fl_value_lookup_string(args, "twts");
+  if (list == nullptr || fl_value_get_type(list) != FL_VALUE_TYPE_LIST) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "bad-args", "observe expects a list of twts", nullptr));
+  }
+  double now = NowSeconds();
+  for (size_t i = 0; i < fl_value_get_length(list); i++) {
+    FlValue* twt = fl_value_get_list_value(list, i);
+    if (fl_value_get_type(twt) != FL_VALUE_TYPE_MAP) {
+      continue;
+    }
+    // Refreshes send the same twts again.
+    std::string hash = LookupString(twt, "hash");
+    if (!hash.empty() && !index->MarkTwtSeen(hash)) {
+      continue;
+    }
+    double time = ParseTime(LookupString(twt, "created"), now);
+    index->Observe(LookupString(twt, "nick"), LookupString(twt, "uri"), time);
+    ObserveMentions(index, LookupString(twt, "text"), time);
+  }
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+FlMethodResponse* AddFollows(MentionIndex* index, FlValue* args) {
+  FlValue* follows = fl_value_lookup_string(args, "follows");
+  if (follows == nullptr || fl_value_get_type(follows) != FL_VALUE_TYPE_MAP) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "bad-args", "addFollows expects a map of follows", nullptr));
+  }
+  double now = NowSeconds();
+  for (size_t i = 0; i < fl_value_get_length(follows); i++) {
+    FlValue* nick = fl_value_get_map_key(follows, i);
+    FlValue* uri = fl_value_get_map_value(follows, i);
+    if (fl_value_get_type(nick) == FL_VALUE_TYPE_STRING &&
+        fl_value_get_type(uri) == FL_VALUE_TYPE_STRING) {
+      index->AddFeed(fl_value_get_string(nick), fl_value_get_string(uri), now);
+    }
+  }
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+FlMethodResponse* Complete(MentionIndex* index, FlValue* args) {
+  FlValue* limit_value = fl_value_lookup_string(args, "limit");
+  size_t limit = MentionIndex::kMaxCompletions;
+  if (limit_value != nullptr &&
+      fl_value_get_type(limit_value) == FL_VALUE_TYPE_INT &&
+      fl_value_get_int(limit_value) >= 0) {
+    limit = static_cast<size_t>(fl_value_get_int(limit_value));
+  }
+
+  g_autoptr(FlValue) result = fl_value_new_list();
+  for (const auto& completion :
+       index->Complete(LookupString(args, "prefix"), limit)) {
+    FlValue* item = fl_value_new_map();
+    fl_value_set_string_take(item, "nick",
+                             fl_value_new_string(completion.nick.c_str()));
+    fl_value_set_string_take(item, "uri",
+                             fl_value_new_string(completion.uri.c_str()));
+    fl_value_append_take(result, item);
+  }
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+void method_call_cb(FlMethodChannel* channel, FlMethodCall* method_call,
+                    gpointer user_data) {
+  MentionIndex* index = static_cast<MentionIndex*>(user_data);
+  const gchar* method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+
+  g_autoptr(FlMethodResponse) response = nullptr;
+  if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
+    response = FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "bad-args", "Expected a map of arguments", nullptr));
+  } else if (strcmp(method, "observe") == 0) {
+    response = Observe(index, args);
+  } else if (strcmp(method, "addFollows") == 0) {
+    response = AddFollows(index, args);
+  } else if (strcmp(method, "complete") == 0) {
+    response = Complete(index, args);
+  } else {
+    response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
+  }
+
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond(method_call, response, &error)) {
+    g_warning("Failed to send mentions response: %s", error->message);
+  }
+}
+
+}  // namespace
+
+FlMethodChannel* mention_index_channel_new(FlBinaryMessenger* messenger,
+                                           MentionIndex* index) {
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  FlMethodChannel* channel = fl_method_channel_new(
+      messenger, "yarndesktopclient/mentions", FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(channel, method_call_cb, index,
+                                            nullptr);
+  return channel;
+}
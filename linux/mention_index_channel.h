@@ -0,0 +1,24 @@
+#ifndef FLUTTER_MENTION_INDEX_CHANNEL_H_
+#define FLUTTER_MENTION_INDEX_CHANNEL_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+#include "mention_index.h"
+
+/**
+ * mention_index_channel_new:
+ * @messenger: an #FlBinaryMessenger.
+ * @index: the #MentionIndex to expose, which must outlive the channel.
+ *
+ * Creates the "yarndesktopclient/mentions" method channel, which handles:
+ *  - observe({twts: [{nick, uri, text, created}]}): indexes the authors of
+ *    the twts and every @<nick url> mention in their text.
+ *  - addFollows({follows: {nick: uri}}): indexes the feeds the user follows.
+ *  - complete({prefix, limit}): returns up to limit [{nick, uri}] matches.
+ *
+ * Returns: a new #FlMethodChannel.
+ */
+FlMethodChannel* mention_index_channel_new(FlBinaryMessenger* messenger,
+                                           MentionIndex* index);
+
+#endif  // FLUTTER_MENTION_INDEX_CHANNEL_H_
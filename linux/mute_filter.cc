@@ -0,0 +1,296 @@
+#include "mute_filter.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+bool IsWordByte(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '_';
+}
+
+std::string ToLower(std::string value) {
+  for (char& c : value) {
+    if (c >= 'A' && c <= 'Z') {
+      c = c - 'A' + 'a';
+    }
+  }
+  return value;
+}
+
+std::string Trim(const std::string& value) {
+  const char* whitespace = " \t\r\n";
+  size_t start = value.find_first_not_of(whitespace);
+  if (start == std::string::npos) {
+    return std::string();
+  }
+  size_t end = value.find_last_not_of(whitespace);
+  return value.substr(start, end - start + 1);
+}
+
+std::string NormalizeFeed(const std::string& feed) {
+  std::string normalized = Trim(feed);
+  while (!normalized.empty() && normalized.back() == '/') {
+    normalized.pop_back();
+  }
+  return normalized;
+}
+
+// Returns the lower-cased hosts of every markdown image, i.e. ![alt](url).
+// Images are matched as TextLayoutCache.parse() does, so ordinary
+// [text](url) links are left out.
+std::vector<std::string> ImageDomains(const std::string& text) {
+  std::vector<std::string> domains;
+  size_t pos = 0;
+  while ((pos = text.find("![", pos)) != std::string::npos) {
+    pos += 2;
+    // The alt text runs up to the first ']', which has to open the URL.
+    size_t alt_end = text.find(']', pos);
+    if (alt_end == std::string::npos) {
+      break;
+    }
+    if (text.compare(alt_end, 2, "](") != 0) {
+      continue;
+    }
+    size_t url = alt_end + 2;
+    size_t close = text.find(')', url);
+    if (close == std::string::npos) {
+      break;
+    }
+    pos = close + 1;
+    size_t scheme = text.find("://", url);
+    if (scheme == std::string::npos || scheme > close) {
+      continue;
+    }
+    size_t host_start = scheme + 3;
+    size_t host_end = text.find_first_of("/:?#)", host_start);
+    if (host_end == std::string::npos || host_end > close) {
+      host_end = close;
+    }
+    if (host_end > host_start) {
+      domains.push_back(ToLower(text.substr(host_start, host_end - host_start)));
+    }
+  }
+  return domains;
+}
+
+std::unordered_set<std::string> NormalizeSet(
+    const std::vector<std::string>& values, std::string (*normalize)(std::string)) {
+  std::unordered_set<std::string> set;
+  for (const std::string& value : values) {
+    std::string normalized = normalize(Trim(value));
+    if (!normalized.empty()) {
+      set.insert(std::move(normalized));
+    }
+  }
+  return set;
+}
+
+std::string FeedKey(std::string value) {
+  return NormalizeFeed(value);
+}
+
+}  // namespace
+
+MuteFilter::MuteFilter() = default;
+
+void MuteFilter::ScanKeywords(const AhoCorasick& automaton,
+                              const std::vector<uint32_t>& ids,
+                              const std::string& text,
+                              std::vector<uint32_t>* keywords) {
+  automaton.Scan(text, [&](uint32_t pattern, size_t end) {
+    size_t start = end - automaton.pattern_length(pattern);
+    // Only require a word boundary where the keyword itself starts or ends
+    // with a word character, so "#tag" or "c++" still match.
+    if (IsWordByte(text[start]) && start > 0 && IsWordByte(text[start - 1])) {
+      return;
+    }
+    if (IsWordByte(text[end - 1]) && end < text.size() &&
+        IsWordByte(text[end])) {
+      return;
+    }
+    uint32_t id = ids[pattern];
+    if (std::find(keywords->begin(), keywords->end(), id) == keywords->end()) {
+      keywords->push_back(id);
+    }
+  });
+}
+
+size_t MuteFilter::SetRules(const MuteRules& rules) {
+  // Work out which keywords were added and removed.
+  std::unordered_set<uint32_t> active;
+  std::vector<std::string> added_patterns;
+  std::vector<uint32_t> added_ids;
+  for (const std::string& keyword : rules.keywords) {
+    std::string normalized = ToLower(Trim(keyword));
+    if (normalized.empty()) {
+      continue;
+    }
+    auto inserted = keyword_ids_.emplace(
+        normalized, static_cast<uint32_t>(keyword_ids_.size()));
+    uint32_t id = inserted.first->second;
+    if (!active.insert(id).second) {
+      continue;
+    }
+    if (active_keywords_.count(id) == 0) {
+      added_patterns.push_back(normalized);
+      added_ids.push_back(id);
+    }
+  }
+  std::unordered_set<uint32_t> removed;
+  for (uint32_t id : active_keywords_) {
+    if (active.count(id) == 0) {
+      removed.insert(id);
+    }
+  }
+
+  if (!added_ids.empty() || !removed.empty()) {
+    std::vector<std::string> patterns;
+    std::vector<uint32_t> ids;
+    for (const auto& entry : keyword_ids_) {
+      if (active.count(entry.second) != 0) {
+        patterns.push_back(entry.first);
+        ids.push_back(entry.second);
+      }
+    }
+    automaton_ = AhoCorasick(patterns);
+    automaton_ids_ = std::move(ids);
+  }
+  AhoCorasick added_automaton(added_patterns);
+  active_keywords_ = std::move(active);
+
+  nicks_ = NormalizeSet(rules.nicks, ToLower);
+  feeds_ = NormalizeSet(rules.feeds, FeedKey);
+  domains_ = NormalizeSet(rules.domains, ToLower);
+
+  size_t changed = 0;
+  for (auto& entry : pages_) {
+    Page& page = entry.second;
+    for (size_t i = 0; i < page.records.size(); i++) {
+      Record& record = page.records[i];
+      if (!removed.empty() && !record.keywords.empty()) {
+        record.keywords.erase(
+            std::remove_if(record.keywords.begin(), record.keywords.end(),
+                           [&](uint32_t id) { return removed.count(id) != 0; }),
+            record.keywords.end());
+      }
+      if (!added_automaton.empty()) {
+        ScanKeywords(added_automaton, added_ids, record.text,
+                     &record.keywords);
+      }
+      uint8_t visible = IsVisible(record) ? 1 : 0;
+      if (visible != page.visible[i]) {
+        page.visible[i] = visible;
+        changed++;
+      }
+    }
+  }
+  return changed;
+}
+
+const std::vector<uint8_t>& MuteFilter::IngestPage(const std::string& page_id,
+                                                   std::vector<Twt> twts) {
+  Page page;
+  page.records.reserve(twts.size());
+  page.visible.reserve(twts.size());
+  for (Twt& twt : twts) {
+    Record record;
+    record.domains = ImageDomains(twt.text);
+    record.nick = ToLower(std::move(twt.nick));
+    record.feed = NormalizeFeed(twt.feed);
+    record.text = std::move(twt.text);
+    ScanKeywords(automaton_, automaton_ids_, record.text, &record.keywords);
+    page.visible.push_back(IsVisible(record) ? 1 : 0);
+    page.records.push_back(std::move(record));
+  }
+  Page& stored = pages_[page_id];
+  stored = std::move(page);
+  return stored.visible;
+}
+
+const std::vector<uint8_t>* MuteFilter::Visibility(
+    const std::string& page_id) const {
+  auto it = pages_.find(page_id);
+  return it == pages_.end() ? nullptr : &it->second.visible;
+}
+
+std::vector<std::string> MuteFilter::PageIds() const {
+  std::vector<std::string> ids;
+  for (const auto& entry : pages_) {
+    ids.push_back(entry.first);
+  }
+  return ids;
+}
+
+size_t MuteFilter::DropPage(const std::string& page_id) {
+  auto it = pages_.find(page_id);
+  if (it == pages_.end()) {
+    return 0;
+  }
+  size_t freed = PageMemoryUsage(it->second);
+  pages_.erase(it);
+  return freed;
+}
+
+size_t MuteFilter::DropPages() {
+  size_t before = memory_usage();
+  pages_.clear();
+  return before - memory_usage();
+}
+
+size_t MuteFilter::memory_usage() const {
+  size_t usage = automaton_.memory_usage();
+  for (const auto& entry : keyword_ids_) {
+    usage += entry.first.capacity() + sizeof(entry);
+  }
+  for (const auto& entry : pages_) {
+    usage += PageMemoryUsage(entry.second);
+  }
+  return usage;
+}
+
+bool MuteFilter::IsVisible(const Record& record) const {
+  if (!record.keywords.empty()) {
+    return false;
+  }
+  if (nicks_.count(record.nick) != 0 || feeds_.count(record.feed) != 0) {
+    return false;
+  }
+  for (const std::string& host : record.domains) {
+    if (IsDomainMuted(host)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool MuteFilter::IsDomainMuted(const std::string& host) const {
+  if (domains_.empty()) {
+    return false;
+  }
+  size_t pos = 0;
+  while (pos != std::string::npos) {
+    if (domains_.count(host.substr(pos)) != 0) {
+      return true;
+    }
+    pos = host.find('.', pos);
+    if (pos != std::string::npos) {
+      pos++;
+    }
+  }
+  return false;
+}
+
+size_t MuteFilter::PageMemoryUsage(const Page& page) {
+  size_t usage = page.visible.capacity();
+  for (const Record& record : page.records) {
+    usage += sizeof(record) + record.text.capacity() + record.nick.capacity() +
+             record.feed.capacity() +
+             record.keywords.capacity() * sizeof(uint32_t);
+    for (const std::string& domain : record.domains) {
+      usage += sizeof(domain) + domain.capacity();
+    }
+  }
+  return usage;
+}
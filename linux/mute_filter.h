@@ -0,0 +1,104 @@
+#ifndef FLUTTER_MUTE_FILTER_H_
+#define FLUTTER_MUTE_FILTER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "aho_corasick.h"
+
+// The user's mute list. Keywords are matched as whole words or phrases,
+// case-insensitively; nicks, feed URIs and image domains by exact value.
+struct MuteRules {
+  std::vector<std::string> keywords;
+  std::vector<std::string> nicks;
+  std::vector<std::string> feeds;
+  // Hides twts embedding images from a domain or any of its subdomains.
+  std::vector<std::string> domains;
+};
+
+// Decides which twts are hidden by the mute list. Twts are ingested a page
+// (one fetched timeline) at a time and a visibility bit is kept per twt, so
+// editing the rules only re-filters what the edit can affect.
+class MuteFilter {
+ public:
+  struct Twt {
+    std::string text;
+    std::string nick;
+    std::string feed;
+  };
+
+  MuteFilter();
+
+  // Replaces the mute list and re-filters every ingested page. Added keywords
+  // are scanned for with an automaton of just those keywords, removed ones
+  // are dropped from the per-twt match lists without rescanning. Returns the
+  // number of twts whose visibility changed.
+  size_t SetRules(const MuteRules& rules);
+
+  // Filters |twts| and stores them as page |page_id|, replacing any previous
+  // page with that id. Returns one visibility byte (0 or 1) per twt.
+  const std::vector<uint8_t>& IngestPage(const std::string& page_id,
+                                         std::vector<Twt> twts);
+
+  // Returns the visibility bytes of |page_id|, or nullptr if it is unknown.
+  const std::vector<uint8_t>* Visibility(const std::string& page_id) const;
+
+  // Returns the ids of every ingested page.
+  std::vector<std::string> PageIds() const;
+
+  // Forgets |page_id| and returns the approximate number of bytes freed.
+  size_t DropPage(const std::string& page_id);
+
+  // Forgets every page, keeping the rules, and returns the approximate
+  // number of bytes freed. Pages have to be ingested again to be re-filtered
+  // by a later SetRules().
+  size_t DropPages();
+
+  // Approximate heap usage of the rules and ingested pages.
+  size_t memory_usage() const;
+
+ private:
+  struct Record {
+    std::string text;
+    std::string nick;
+    std::string feed;
+    std::vector<std::string> domains;
+    // Ids of the keywords found in |text|, see |keyword_ids_|.
+    std::vector<uint32_t> keywords;
+  };
+
+  struct Page {
+    std::vector<Record> records;
+    std::vector<uint8_t> visible;
+  };
+
+  // Appends the ids of every keyword of |automaton| that occurs as a whole
+  // word in |text| to |keywords|. |ids| maps automaton patterns to ids.
+  static void ScanKeywords(const AhoCorasick& automaton,
+                           const std::vector<uint32_t>& ids,
+                           const std::string& text,
+                           std::vector<uint32_t>* keywords);
+
+  bool IsVisible(const Record& record) const;
+  bool IsDomainMuted(const std::string& host) const;
+  static size_t PageMemoryUsage(const Page& page);
+
+  // Stable id per normalized keyword, never reused within a session so
+  // per-twt match lists stay valid across rule edits.
+  std::unordered_map<std::string, uint32_t> keyword_ids_;
+  std::unordered_set<uint32_t> active_keywords_;
+  AhoCorasick automaton_;
+  std::vector<uint32_t> automaton_ids_;
+
+  std::unordered_set<std::string> nicks_;
+  std::unordered_set<std::string> feeds_;
+  std::unordered_set<std::string> domains_;
+
+  std::unordered_map<std::string, Page> pages_;
+};
+
+#endif  // FLUTTER_MUTE_FILTER_H_
@@ -0,0 +1,128 @@
+#include "mute_filter_channel.h"
+
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Returns the string at |key| in |map|, or an empty string.
+std::string LookupString(FlValue* map, const char* key) {
+  FlValue* value = fl_value_lookup_string(map, key);
+  if (value == nullptr || fl_value_get_type(value) != FL_VALUE_TYPE_STRING) {
+    return std::string();
+  }
+  return fl_value_get_string(value);
+}
+
+// Returns the strings in the list at |key| in |map|.
+std::vector<std::string> LookupStrings(FlValue* map, const char* key) {
+  std::vector<std::string> strings;
+  FlValue* list = fl_value_lookup_string(map, key);
+  if (list == nullptr || fl_value_get_type(list) != FL_VALUE_TYPE_LIST) {
+    return strings;
+  }
+  for (size_t i = 0; i < fl_value_get_length(list); i++) {
+    FlValue* value = fl_value_get_list_value(list, i);
+    if (fl_value_get_type(value) == FL_VALUE_TYPE_STRING) {
+      strings.push_back(fl_value_get_string(value));
+    }
+  }
+  return strings;
+}
+
+FlValue* NewVisibilityValue(const std::vector<uint8_t>& visible) {
+  return fl_value_new_uint8_list(visible.data(), visible.size());
+}
+
+FlMethodResponse* SetRules(MuteFilter* filter, FlValue* args) {
+  MuteRules rules;
+  rules.keywords = LookupStrings(args, "keywords");
+  rules.nicks = LookupStrings(args, "nicks");
+  rules.feeds = LookupStrings(args, "feeds");
+  rules.domains = LookupStrings(args, "domains");
+  size_t changed = filter->SetRules(rules);
+  g_debug("Mute rules updated, %zu twts changed visibility", changed);
+
+  g_autoptr(FlValue) result = fl_value_new_map();
+  for (const std::string& page_id : filter->PageIds()) {
+    fl_value_set_string_take(result, page_id.c_str(),
+                             NewVisibilityValue(*filter->Visibility(page_id)));
+  }
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+FlMethodResponse* IngestPage(MuteFilter* filter, FlValue* args) {
+  FlValue* list = fl_value_lookup_string(args, "twts");
+  std::string page_id = LookupString(args, "page");
+  if (list == nullptr || fl_value_get_type(list) != FL_VALUE_TYPE_LIST ||
+      page_id.empty()) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "bad-args", "ingestPage expects a page id and a list of twts",
+        nullptr));
+  }
+
+  std::vector<MuteFilter::Twt> twts;
+  twts.reserve(fl_value_get_length(list));
+  for (size_t i = 0; i < fl_value_get_length(list); i++) {
+    FlValue* item = fl_value_get_list_value(list, i);
+    if (fl_value_get_type(item) != FL_VALUE_TYPE_MAP) {
+      twts.emplace_back();
+      continue;
+    }
+    MuteFilter::Twt twt;
+    twt.text = LookupString(item, "text");
+    twt.nick = LookupString(item, "nick");
+    twt.feed = LookupString(item, "uri");
+    twts.push_back(std::move(twt));
+  }
+
+  g_autoptr(FlValue) result = NewVisibilityValue(
+      filter->IngestPage(page_id, std::move(twts)));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+FlMethodResponse* DropPage(MuteFilter* filter, FlValue* args) {
+  size_t freed = filter->DropPage(LookupString(args, "page"));
+  g_autoptr(FlValue) result = fl_value_new_int(static_cast<int64_t>(freed));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+void method_call_cb(FlMethodChannel* channel, FlMethodCall* method_call,
+                    gpointer user_data) {
+  MuteFilter* filter = static_cast<MuteFilter*>(user_data);
+  const gchar* method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+
+  g_autoptr(FlMethodResponse) response = nullptr;
+  if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
+    response = FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "bad-args", "Expected a map of arguments", nullptr));
+  } else if (strcmp(method, "setRules") == 0) {
+    response = SetRules(filter, args);
+  } else if (strcmp(method, "ingestPage") == 0) {
+    response = IngestPage(filter, args);
+  } else if (strcmp(method, "dropPage") == 0) {
+    response = DropPage(filter, args);
+  } else {
+    response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
+  }
+
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond(method_call, response, &error)) {
+    g_warning("Failed to send filter response: %s", error->message);
+  }
+}
+
+}  // namespace
+
+FlMethodChannel* mute_filter_channel_new(FlBinaryMessenger* messenger,
+                                         MuteFilter* filter) {
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  FlMethodChannel* channel = fl_method_channel_new(
+      messenger, "yarndesktopclient/filter", FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(channel, method_call_cb, filter,
+                                            nullptr);
+  return channel;
+}
@@ -0,0 +1,25 @@
+#ifndef FLUTTER_MUTE_FILTER_CHANNEL_H_
+#define FLUTTER_MUTE_FILTER_CHANNEL_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+#include "mute_filter.h"
+
+/**
+ * mute_filter_channel_new:
+ * @messenger: an #FlBinaryMessenger.
+ * @filter: the #MuteFilter to expose, which must outlive the channel.
+ *
+ * Creates the "yarndesktopclient/filter" method channel, which handles:
+ *  - setRules({keywords, nicks, feeds, domains}): replaces the mute list and
+ *    returns a map from page id to the new visibility bytes of that page.
+ *  - ingestPage({page, twts: [{text, nick, uri}]}): filters a timeline page
+ *    and returns one visibility byte per twt.
+ *  - dropPage({page}): forgets a page and returns the bytes freed.
+ *
+ * Returns: a new #FlMethodChannel.
+ */
+FlMethodChannel* mute_filter_channel_new(FlBinaryMessenger* messenger,
+                                         MuteFilter* filter);
+
+#endif  // FLUTTER_MUTE_FILTER_CHANNEL_H_
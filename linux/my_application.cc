@@ -6,14 +6,135 @@
 #endif
 
 #include "flutter/generated_plugin_registrant.h"
+#include "memory_trimmer.h"
+#include "mention_index.h"
+#include "mention_index_channel.h"
+#include "mute_filter.h"
+#include "mute_filter_channel.h"
+#include "read_state_channel.h"
+#include "read_state_store.h"
+#include "timeline_cache_channel.h"
+#include "timeline_transport_channel.h"
 
 struct _MyApplication {
   GtkApplication parent_instance;
   char** dart_entrypoint_arguments;
+  GMemoryMonitor* memory_monitor;
+  FlMethodChannel* memory_channel;
+  MemoryTrimmer* memory_trimmer;
+  MuteFilter* mute_filter;
+  FlMethodChannel* filter_channel;
+  ReadStateStore* read_state;
+  FlMethodChannel* read_state_channel;
+  FlMethodChannel* cache_channel;
+  FlMethodChannel* transport_channel;
+  MentionIndex* mention_index;
+  FlMethodChannel* mentions_channel;
 };
 
 G_DEFINE_TYPE(MyApplication, my_application, GTK_TYPE_APPLICATION)
 
+// State carried across the asynchronous trimMemory call into Dart.
+typedef struct {
+  MyApplication* self;
+  TrimLevel level;
+  size_t native_freed;
+} TrimRequest;
+
+// Called when Dart has finished trimming its caches.
+static void trim_memory_cb(GObject* object, GAsyncResult* result,
+                           gpointer user_data) {
+  TrimRequest* request = static_cast<TrimRequest*>(user_data);
+  g_autoptr(GError) error = nullptr;
+  g_autoptr(FlMethodResponse) response = fl_method_channel_invoke_method_finish(
+      FL_METHOD_CHANNEL(object), result, &error);
+
+  size_t dart_freed = 0;
+  if (response == nullptr) {
+    g_warning("Failed to trim Dart caches: %s", error->message);
+  } else {
+    FlValue* value = fl_method_response_get_result(response, &error);
+    if (value == nullptr) {
+      g_warning("Failed to trim Dart caches: %s", error->message);
+    } else if (fl_value_get_type(value) == FL_VALUE_TYPE_INT) {
+      dart_freed = static_cast<size_t>(fl_value_get_int(value));
+    }
+  }
+
+  request->self->memory_trimmer->AddFreed(dart_freed);
+  g_message("Memory trim (%s): freed %zu bytes native, %zu bytes Dart, "
+            "%zu bytes total this session",
+            TrimLevelName(request->level), request->native_freed, dart_freed,
+            request->self->memory_trimmer->total_freed());
+
+  g_object_unref(request->self);
+  g_free(request);
+}
+
+// Drops the caches appropriate for |level| on both the native and Dart side.
+static void my_application_trim_memory(MyApplication* self, TrimLevel level) {
+  if (!self->memory_trimmer->ShouldTrim(level, g_get_monotonic_time())) {
+    return;
+  }
+
+  size_t native_freed = self->memory_trimmer->TrimNative(level);
+  if (self->memory_channel == nullptr) {
+    g_message("Memory trim (%s): freed %zu bytes native",
+              TrimLevelName(level), native_freed);
+    return;
+  }
+
+  g_autoptr(FlValue) tiers = fl_value_new_list();
+  for (TrimTier tier : MemoryTrimmer::TiersForLevel(level)) {
+    fl_value_append_take(tiers, fl_value_new_string(TrimTierName(tier)));
+  }
+  g_autoptr(FlValue) args = fl_value_new_map();
+  fl_value_set_string_take(args, "level",
+                           fl_value_new_string(TrimLevelName(level)));
+  fl_value_set_string(args, "tiers", tiers);
+
+  TrimRequest* request = g_new0(TrimRequest, 1);
+  request->self = MY_APPLICATION(g_object_ref(self));
+  request->level = level;
+  request->native_freed = native_freed;
+  fl_method_channel_invoke_method(self->memory_channel, "trimMemory", args,
+                                  nullptr, trim_memory_cb, request);
+}
+
+// Called by GMemoryMonitor when the system is running low on memory.
+static void low_memory_warning_cb(GMemoryMonitor* monitor,
+                                  GMemoryMonitorWarningLevel warning_level,
+                                  gpointer user_data) {
+  MyApplication* self = MY_APPLICATION(user_data);
+  TrimLevel level = TrimLevel::kLow;
+  if (warning_level >= G_MEMORY_MONITOR_WARNING_LEVEL_CRITICAL) {
+    level = TrimLevel::kCritical;
+  } else if (warning_level >= G_MEMORY_MONITOR_WARNING_LEVEL_MEDIUM) {
+    level = TrimLevel::kMedium;
+  }
+  my_application_trim_memory(self, level);
+}
+
+// Trims caches when the window is minimized or withdrawn.
+static gboolean window_state_event_cb(GtkWidget* widget,
+                                      GdkEventWindowState* event,
+                                      gpointer user_data) {
+  const GdkWindowState hidden =
+      static_cast<GdkWindowState>(GDK_WINDOW_STATE_ICONIFIED |
+                                  GDK_WINDOW_STATE_WITHDRAWN);
+  if ((event->changed_mask & hidden) && (event->new_window_state & hidden)) {
+    my_application_trim_memory(MY_APPLICATION(user_data),
+                               TrimLevel::kBackground);
+  }
+  return FALSE;
+}
+
+// Trims caches when the window is hidden, e.g. to a tray.
+static void window_hide_cb(GtkWidget* widget, gpointer user_data) {
+  my_application_trim_memory(MY_APPLICATION(user_data),
+                             TrimLevel::kBackground);
+}
+
 // Implements GApplication::activate.
 static void my_application_activate(GApplication* application) {
   MyApplication* self = MY_APPLICATION(application);
@@ -59,6 +180,29 @@ static void my_application_activate(GApplication* application) {
 
   fl_register_plugins(FL_PLUGIN_REGISTRY(view));
 
+  FlBinaryMessenger* messenger =
+      fl_engine_get_binary_messenger(fl_view_get_engine(view));
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  g_clear_object(&self->memory_channel);
+  self->memory_channel = fl_method_channel_new(
+      messenger, "yarndesktopclient/memory", FL_METHOD_CODEC(codec));
+  g_clear_object(&self->filter_channel);
+  self->filter_channel = mute_filter_channel_new(messenger, self->mute_filter);
+  g_clear_object(&self->read_state_channel);
+  self->read_state_channel = read_state_channel_new(messenger, self->read_state);
+  g_clear_object(&self->cache_channel);
+  self->cache_channel = timeline_cache_channel_new(messenger);
+  g_clear_object(&self->transport_channel);
+  self->transport_channel = timeline_transport_channel_new(messenger);
+  g_clear_object(&self->mentions_channel);
+  self->mentions_channel =
+      mention_index_channel_new(messenger, self->mention_index);
+  g_signal_connect_object(window, "window-state-event",
+                          G_CALLBACK(window_state_event_cb), self,
+                          static_cast<GConnectFlags>(0));
+  g_signal_connect_object(window, "hide", G_CALLBACK(window_hide_cb), self,
+                          static_cast<GConnectFlags>(0));
+
   gtk_widget_grab_focus(GTK_WIDGET(view));
 }
 
@@ -83,18 +227,23 @@ static gboolean my_application_local_command_line(GApplication* application, gch
 
 // Implements GApplication::startup.
 static void my_application_startup(GApplication* application) {
-  //MyApplication* self = MY_APPLICATION(object);
+  MyApplication* self = MY_APPLICATION(application);
 
   // Perform any actions required at application startup.
+  self->memory_monitor = g_memory_monitor_dup_default();
+  g_signal_connect_object(self->memory_monitor, "low-memory-warning",
+                          G_CALLBACK(low_memory_warning_cb), self,
+                          static_cast<GConnectFlags>(0));
 
   G_APPLICATION_CLASS(my_application_parent_class)->startup(application);
 }
 
 // Implements GApplication::shutdown.
 static void my_application_shutdown(GApplication* application) {
-  //MyApplication* self = MY_APPLICATION(object);
+  MyApplication* self = MY_APPLICATION(application);
 
   // Perform any actions required at application shutdown.
+  self->read_state->Save();
 
   G_APPLICATION_CLASS(my_application_parent_class)->shutdown(application);
 }
@@ -103,6 +252,21 @@ static void my_application_shutdown(GApplication* application) {
 static void my_application_dispose(GObject* object) {
   MyApplication* self = MY_APPLICATION(object);
   g_clear_pointer(&self->dart_entrypoint_arguments, g_strfreev);
+  g_clear_object(&self->memory_monitor);
+  g_clear_object(&self->memory_channel);
+  g_clear_object(&self->filter_channel);
+  g_clear_object(&self->read_state_channel);
+  g_clear_object(&self->cache_channel);
+  g_clear_object(&self->transport_channel);
+  g_clear_object(&self->mentions_channel);
+  delete self->mention_index;
+  self->mention_index = nullptr;
+  delete self->read_state;
+  self->read_state = nullptr;
+  delete self->mute_filter;
+  self->mute_filter = nullptr;
+  delete self->memory_trimmer;
+  self->memory_trimmer = nullptr;
   G_OBJECT_CLASS(my_application_parent_class)->dispose(object);
 }
 
@@ -114,7 +278,31 @@ static void my_application_class_init(MyApplicationClass* klass) {
   G_OBJECT_CLASS(klass)->dispose = my_application_dispose;
 }
 
-static void my_application_init(MyApplication* self) {}
+// Feeds kept in the completion index under critical memory pressure.
+static constexpr size_t kTrimmedMentionEntries = 1024;
+
+static void my_application_init(MyApplication* self) {
+  self->memory_trimmer = new MemoryTrimmer();
+  self->mute_filter = new MuteFilter();
+  self->read_state = new ReadStateStore();
+  self->mention_index = new MentionIndex();
+
+  // The caches outlive none of these callbacks; all are freed in dispose.
+  MuteFilter* mute_filter = self->mute_filter;
+  self->memory_trimmer->Register(
+      "mute-filter", TrimTier::kParseResults,
+      [mute_filter](TrimLevel level) { return mute_filter->DropPages(); });
+  ReadStateStore* read_state = self->read_state;
+  self->memory_trimmer->Register(
+      "read-state", TrimTier::kParseResults,
+      [read_state](TrimLevel level) { return read_state->state()->Compact(); });
+  MentionIndex* mention_index = self->mention_index;
+  self->memory_trimmer->Register(
+      "mention-index", TrimTier::kParseResults,
+      [mention_index](TrimLevel level) {
+        return mention_index->Prune(kTrimmedMentionEntries);
+      });
+}
 
 MyApplication* my_application_new() {
   return MY_APPLICATION(g_object_new(my_application_get_type(),
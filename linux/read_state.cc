@@ -0,0 +1,227 @@
+#include "read_state.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+// Headers of the ordinal log and the markers, each with a format version.
+constexpr char kOrdinalsMagic[4] = {'Y', 'R', 'O', '1'};
+constexpr char kMarkersMagic[4] = {'Y', 'R', 'S', '2'};
+
+void PutU32(std::string* out, uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    out->push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+bool GetU32(const char** data, const char* end, uint32_t* value) {
+  if (end - *data < 4) {
+    return false;
+  }
+  *value = 0;
+  for (int i = 0; i < 4; i++) {
+    *value |= static_cast<uint32_t>(static_cast<uint8_t>((*data)[i]))
+              << (8 * i);
+  }
+  *data += 4;
+  return true;
+}
+
+}  // namespace
+
+ReadState::ReadState() = default;
+
+bool ReadState::Deserialize(const std::string& ordinals,
+                            const std::string& markers, bool* complete) {
+  Reset();
+  *complete = true;
+
+  const char* cursor = ordinals.data();
+  const char* end = cursor + ordinals.size();
+  bool ok = ordinals.empty() ||
+            (ordinals.size() >= sizeof(kOrdinalsMagic) &&
+             std::equal(kOrdinalsMagic,
+                        kOrdinalsMagic + sizeof(kOrdinalsMagic), cursor));
+  cursor += ordinals.empty() ? 0 : sizeof(kOrdinalsMagic);
+  while (ok && cursor < end) {
+    uint32_t length = 0;
+    if (!GetU32(&cursor, end, &length) ||
+        static_cast<size_t>(end - cursor) < length) {
+      *complete = false;
+      break;
+    }
+    // A hash logged twice keeps its first ordinal; the second one is unused.
+    auto inserted =
+        ordinals_.emplace(std::string(cursor, length), next_ordinal_++);
+    hashes_.push_back(&inserted.first->first);
+    cursor += length;
+  }
+  if (!ok) {
+    Reset();
+    return false;
+  }
+
+  if (markers.empty()) {
+    return true;
+  }
+  cursor = markers.data();
+  end = cursor + markers.size();
+  uint32_t count = 0;
+  ok = markers.size() >= sizeof(kMarkersMagic) &&
+       std::equal(kMarkersMagic, kMarkersMagic + sizeof(kMarkersMagic),
+                  cursor);
+  cursor += ok ? sizeof(kMarkersMagic) : 0;
+  // Markers written after ordinals that did not reach the log would mark
+  // the wrong twts once those ordinals are given out again.
+  ok = ok && GetU32(&cursor, end, &count) && count <= next_ordinal_ &&
+       read_.Deserialize(&cursor, end);
+  if (!ok) {
+    read_.Clear();
+  }
+  return ok;
+}
+
+std::string ReadState::SerializeOrdinals(uint32_t first) const {
+  std::string out;
+  if (first == 0) {
+    out.append(kOrdinalsMagic, sizeof(kOrdinalsMagic));
+  }
+  for (uint32_t ordinal = first; ordinal < next_ordinal_; ordinal++) {
+    const std::string& hash = *hashes_[ordinal];
+    PutU32(&out, static_cast<uint32_t>(hash.size()));
+    out += hash;
+  }
+  return out;
+}
+
+std::string ReadState::SerializeMarkers() {
+  read_.Optimize();
+  std::string out(kMarkersMagic, sizeof(kMarkersMagic));
+  PutU32(&out, next_ordinal_);
+  read_.Serialize(&out);
+  dirty_ = false;
+  return out;
+}
+
+size_t ReadState::SetTab(const std::string& tab,
+                         const std::vector<std::string>& hashes) {
+  Tab& state = tabs_[tab];
+  state.rows.clear();
+  state.rows.reserve(hashes.size());
+  state.members.Clear();
+  state.unread = 0;
+  for (const std::string& hash : hashes) {
+    uint32_t ordinal = OrdinalFor(hash);
+    state.rows.push_back(ordinal);
+    // Count each twt once even if the tab lists it twice.
+    if (state.members.Add(ordinal) && !read_.Contains(ordinal)) {
+      state.unread++;
+    }
+  }
+  return state.unread;
+}
+
+size_t ReadState::MarkRowsRead(const std::string& tab, size_t first,
+                               size_t last) {
+  auto it = tabs_.find(tab);
+  if (it == tabs_.end() || it->second.rows.empty() || first > last) {
+    return 0;
+  }
+  const std::vector<uint32_t>& rows = it->second.rows;
+  last = std::min(last, rows.size() - 1);
+
+  std::vector<uint32_t> newly_read;
+  for (size_t row = first; row <= last; row++) {
+    uint32_t ordinal = rows[row];
+    if (!read_.Contains(ordinal)) {
+      newly_read.push_back(ordinal);
+    }
+  }
+  if (newly_read.empty()) {
+    return 0;
+  }
+
+  // Newly seen twts get consecutive ordinals, so sorting usually leaves a few
+  // long runs that the bitmap stores as ranges.
+  std::sort(newly_read.begin(), newly_read.end());
+  newly_read.erase(std::unique(newly_read.begin(), newly_read.end()),
+                   newly_read.end());
+  for (size_t start = 0; start < newly_read.size();) {
+    size_t end = start;
+    while (end + 1 < newly_read.size() &&
+           newly_read[end + 1] == newly_read[end] + 1) {
+      end++;
+    }
+    read_.AddRange(newly_read[start], newly_read[end]);
+    start = end + 1;
+  }
+
+  // The same twt can be in several tabs, e.g. Discover and Mentions.
+  for (auto& entry : tabs_) {
+    Tab& state = entry.second;
+    for (uint32_t ordinal : newly_read) {
+      if (state.unread > 0 && state.members.Contains(ordinal)) {
+        state.unread--;
+      }
+    }
+  }
+  dirty_ = true;
+  return newly_read.size();
+}
+
+size_t ReadState::UnreadCount(const std::string& tab) const {
+  auto it = tabs_.find(tab);
+  return it == tabs_.end() ? 0 : it->second.unread;
+}
+
+std::map<std::string, size_t> ReadState::UnreadCounts() const {
+  std::map<std::string, size_t> counts;
+  for (const auto& entry : tabs_) {
+    counts[entry.first] = entry.second.unread;
+  }
+  return counts;
+}
+
+size_t ReadState::Compact() {
+  size_t before = memory_usage();
+  read_.Optimize();
+  hashes_.shrink_to_fit();
+  for (auto& entry : tabs_) {
+    entry.second.rows.shrink_to_fit();
+    entry.second.members.Optimize();
+  }
+  size_t after = memory_usage();
+  return before > after ? before - after : 0;
+}
+
+size_t ReadState::memory_usage() const {
+  size_t usage = read_.memory_usage();
+  for (const auto& entry : ordinals_) {
+    usage += sizeof(entry) + entry.first.capacity();
+  }
+  usage += hashes_.capacity() * sizeof(const std::string*);
+  for (const auto& entry : tabs_) {
+    usage += entry.second.rows.capacity() * sizeof(uint32_t) +
+             entry.second.members.memory_usage();
+  }
+  return usage;
+}
+
+void ReadState::Reset() {
+  ordinals_.clear();
+  hashes_.clear();
+  next_ordinal_ = 0;
+  read_.Clear();
+  tabs_.clear();
+  dirty_ = false;
+}
+
+uint32_t ReadState::OrdinalFor(const std::string& hash) {
+  auto inserted = ordinals_.emplace(hash, next_ordinal_);
+  if (inserted.second) {
+    hashes_.push_back(&inserted.first->first);
+    next_ordinal_++;
+  }
+  return inserted.first->second;
+}
@@ -0,0 +1,90 @@
+#ifndef FLUTTER_READ_STATE_H_
+#define FLUTTER_READ_STATE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "roaring_bitmap.h"
+
+// Remembers which twts of one account have been read and keeps an unread
+// count per timeline tab.
+//
+// Every twt hash is given a stable ordinal the first time it is seen, and
+// read markers are a compressed bitmap over those ordinals. Each tab keeps
+// its rows' ordinals and a running unread count, so counts are O(1) to query
+// and marking a range of rows read only touches those rows.
+//
+// Ordinals are never reassigned, so they are persisted as an append-only log
+// of hashes and only the (small) markers are rewritten on each save.
+class ReadState {
+ public:
+  ReadState();
+
+  // Replaces the state with the ordinal log |ordinals| and the read markers
+  // |markers|, as produced by SerializeOrdinals() and SerializeMarkers();
+  // either may be empty. A truncated last record in the log, e.g. from an
+  // interrupted append, is dropped and |*complete| is set to false. Returns
+  // false on malformed input, leaving the state empty, or only the markers
+  // cleared if they do not match the log.
+  bool Deserialize(const std::string& ordinals, const std::string& markers,
+                   bool* complete);
+
+  // Encodes the hashes of ordinals |first| onwards as log records, preceded
+  // by the log header if |first| is 0.
+  std::string SerializeOrdinals(uint32_t first) const;
+
+  // Encodes the read markers; tabs are not persisted.
+  std::string SerializeMarkers();
+
+  // Sets the rows shown in |tab| to the twts with |hashes|, in order, and
+  // returns the tab's unread count.
+  size_t SetTab(const std::string& tab, const std::vector<std::string>& hashes);
+
+  // Marks rows [first, last] of |tab| as read and returns how many of them
+  // were unread.
+  size_t MarkRowsRead(const std::string& tab, size_t first, size_t last);
+
+  // Number of unread rows in |tab|.
+  size_t UnreadCount(const std::string& tab) const;
+
+  // Unread count of every tab, by tab id.
+  std::map<std::string, size_t> UnreadCounts() const;
+
+  // Compresses the bitmaps and releases spare capacity. Returns the
+  // approximate number of bytes freed.
+  size_t Compact();
+
+  // True if the read markers changed since they were last serialized.
+  bool dirty() const { return dirty_; }
+
+  // Number of ordinals given out so far.
+  uint32_t ordinal_count() const { return next_ordinal_; }
+
+  // Approximate heap usage.
+  size_t memory_usage() const;
+
+ private:
+  struct Tab {
+    std::vector<uint32_t> rows;
+    RoaringBitmap members;
+    size_t unread = 0;
+  };
+
+  uint32_t OrdinalFor(const std::string& hash);
+
+  void Reset();
+
+  std::unordered_map<std::string, uint32_t> ordinals_;
+  // The hash of each ordinal, pointing into the keys of ordinals_.
+  std::vector<const std::string*> hashes_;
+  uint32_t next_ordinal_ = 0;
+  RoaringBitmap read_;
+  std::map<std::string, Tab> tabs_;
+  bool dirty_ = false;
+};
+
+#endif  // FLUTTER_READ_STATE_H_
@@ -0,0 +1,119 @@
+#include "read_state_channel.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string LookupString(FlValue* map, const char* key) {
+  FlValue* value = fl_value_lookup_string(map, key);
+  if (value == nullptr || fl_value_get_type(value) != FL_VALUE_TYPE_STRING) {
+    return std::string();
+  }
+  return fl_value_get_string(value);
+}
+
+int64_t LookupInt(FlValue* map, const char* key, int64_t fallback) {
+  FlValue* value = fl_value_lookup_string(map, key);
+  if (value == nullptr || fl_value_get_type(value) != FL_VALUE_TYPE_INT) {
+    return fallback;
+  }
+  return fl_value_get_int(value);
+}
+
+FlMethodResponse* UnreadCountsResponse(ReadStateStore* store) {
+  g_autoptr(FlValue) result = fl_value_new_map();
+  for (const auto& entry : store->state()->UnreadCounts()) {
+    fl_value_set_string_take(result, entry.first.c_str(),
+                             fl_value_new_int(static_cast<int64_t>(entry.second)));
+  }
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+FlMethodResponse* BadArgs(const char* message) {
+  return FL_METHOD_RESPONSE(
+      fl_method_error_response_new("bad-args", message, nullptr));
+}
+
+FlMethodResponse* OpenAccount(ReadStateStore* store, FlValue* args) {
+  std::string account = LookupString(args, "account");
+  if (account.empty()) {
+    return BadArgs("openAccount expects an account");
+  }
+  store->Open(account);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+FlMethodResponse* SetTab(ReadStateStore* store, FlValue* args) {
+  std::string tab = LookupString(args, "tab");
+  FlValue* list = fl_value_lookup_string(args, "hashes");
+  if (tab.empty() || list == nullptr ||
+      fl_value_get_type(list) != FL_VALUE_TYPE_LIST) {
+    return BadArgs("setTab expects a tab and a list of hashes");
+  }
+  std::vector<std::string> hashes;
+  hashes.reserve(fl_value_get_length(list));
+  for (size_t i = 0; i < fl_value_get_length(list); i++) {
+    FlValue* value = fl_value_get_list_value(list, i);
+    hashes.push_back(fl_value_get_type(value) == FL_VALUE_TYPE_STRING
+                         ? fl_value_get_string(value)
+                         : "");
+  }
+  store->state()->SetTab(tab, hashes);
+  store->ScheduleSave();
+  return UnreadCountsResponse(store);
+}
+
+FlMethodResponse* MarkRead(ReadStateStore* store, FlValue* args) {
+  std::string tab = LookupString(args, "tab");
+  int64_t first = LookupInt(args, "first", -1);
+  int64_t last = LookupInt(args, "last", -1);
+  if (tab.empty() || first < 0 || last < first) {
+    return BadArgs("markRead expects a tab and a row range");
+  }
+  if (store->state()->MarkRowsRead(tab, static_cast<size_t>(first),
+                                   static_cast<size_t>(last)) > 0) {
+    store->ScheduleSave();
+  }
+  return UnreadCountsResponse(store);
+}
+
+void method_call_cb(FlMethodChannel* channel, FlMethodCall* method_call,
+                    gpointer user_data) {
+  ReadStateStore* store = static_cast<ReadStateStore*>(user_data);
+  const gchar* method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+
+  g_autoptr(FlMethodResponse) response = nullptr;
+  if (strcmp(method, "unreadCounts") == 0) {
+    response = UnreadCountsResponse(store);
+  } else if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
+    response = BadArgs("Expected a map of arguments");
+  } else if (strcmp(method, "openAccount") == 0) {
+    response = OpenAccount(store, args);
+  } else if (strcmp(method, "setTab") == 0) {
+    response = SetTab(store, args);
+  } else if (strcmp(method, "markRead") == 0) {
+    response = MarkRead(store, args);
+  } else {
+    response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
+  }
+
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond(method_call, response, &error)) {
+    g_warning("Failed to send read state response: %s", error->message);
+  }
+}
+
+}  // namespace
+
+FlMethodChannel* read_state_channel_new(FlBinaryMessenger* messenger,
+                                        ReadStateStore* store) {
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  FlMethodChannel* channel = fl_method_channel_new(
+      messenger, "yarndesktopclient/readstate", FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(channel, method_call_cb, store,
+                                            nullptr);
+  return channel;
+}
@@ -0,0 +1,25 @@
+#ifndef FLUTTER_READ_STATE_CHANNEL_H_
+#define FLUTTER_READ_STATE_CHANNEL_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+#include "read_state_store.h"
+
+/**
+ * read_state_channel_new:
+ * @messenger: an #FlBinaryMessenger.
+ * @store: the #ReadStateStore to expose, which must outlive the channel.
+ *
+ * Creates the "yarndesktopclient/readstate" method channel, which handles:
+ *  - openAccount({account}): loads the read markers of an account.
+ *  - setTab({tab, hashes}): sets the twts shown in a tab, in row order.
+ *  - markRead({tab, first, last}): marks rows [first, last] of a tab read.
+ *  - unreadCounts(): returns the unread counts.
+ * Every method except openAccount returns a map from tab to unread count.
+ *
+ * Returns: a new #FlMethodChannel.
+ */
+FlMethodChannel* read_state_channel_new(FlBinaryMessenger* messenger,
+                                        ReadStateStore* store);
+
+#endif  // FLUTTER_READ_STATE_CHANNEL_H_
@@ -0,0 +1,133 @@
+#include "read_state_store.h"
+
+#include <gio/gio.h>
+
+namespace {
+
+constexpr guint kSaveDelaySeconds = 2;
+
+// Returns the file holding the read state of |account| with |extension|.
+std::string PathForAccount(const std::string& account,
+                           const char* extension) {
+  g_autofree gchar* digest =
+      g_compute_checksum_for_string(G_CHECKSUM_SHA256, account.c_str(), -1);
+  g_autofree gchar* name = g_strconcat(digest, extension, nullptr);
+  g_autofree gchar* path =
+      g_build_filename(g_get_user_data_dir(), "yarndesktopclient",
+                       "read-state", name, nullptr);
+  return path;
+}
+
+// Reads |path| into |contents|, which is left empty if there is no file.
+void ReadFile(const std::string& path, std::string* contents) {
+  g_autofree gchar* data = nullptr;
+  gsize length = 0;
+  g_autoptr(GError) error = nullptr;
+  contents->clear();
+  if (!g_file_get_contents(path.c_str(), &data, &length, &error)) {
+    if (!g_error_matches(error, G_FILE_ERROR, G_FILE_ERROR_NOENT)) {
+      g_warning("Failed to read %s: %s", path.c_str(), error->message);
+    }
+    return;
+  }
+  contents->assign(data, length);
+}
+
+}  // namespace
+
+ReadStateStore::ReadStateStore() = default;
+
+ReadStateStore::~ReadStateStore() {
+  Save();
+}
+
+void ReadStateStore::Open(const std::string& account) {
+  std::string path = PathForAccount(account, ".bin");
+  if (path == path_) {
+    return;
+  }
+  Save();
+  path_ = path;
+  ordinals_path_ = PathForAccount(account, ".ordinals");
+
+  std::string ordinals;
+  std::string markers;
+  ReadFile(ordinals_path_, &ordinals);
+  ReadFile(path_, &markers);
+  bool complete = true;
+  if (!state_.Deserialize(ordinals, markers, &complete)) {
+    g_warning("Ignoring corrupt read state in %s", path_.c_str());
+  }
+  // A log with a torn last record is rewritten before anything is appended.
+  saved_ordinals_ = complete ? state_.ordinal_count() : 0;
+}
+
+void ReadStateStore::ScheduleSave() {
+  if (save_source_id_ != 0) {
+    return;
+  }
+  save_source_id_ = g_timeout_add_seconds(kSaveDelaySeconds, SaveTimeoutCb, this);
+}
+
+void ReadStateStore::Save() {
+  if (save_source_id_ != 0) {
+    g_source_remove(save_source_id_);
+    save_source_id_ = 0;
+  }
+  if (path_.empty() ||
+      (!state_.dirty() && state_.ordinal_count() == saved_ordinals_)) {
+    return;
+  }
+
+  g_autofree gchar* dir = g_path_get_dirname(path_.c_str());
+  if (g_mkdir_with_parents(dir, 0700) != 0) {
+    g_warning("Failed to create %s", dir);
+    return;
+  }
+  // The markers refer to ordinals, so they are only written once those
+  // ordinals are in the log.
+  if (state_.ordinal_count() != saved_ordinals_ && !SaveOrdinals()) {
+    return;
+  }
+  if (!state_.dirty()) {
+    return;
+  }
+  std::string data = state_.SerializeMarkers();
+  g_autoptr(GError) error = nullptr;
+  if (!g_file_set_contents(path_.c_str(), data.data(),
+                           static_cast<gssize>(data.size()), &error)) {
+    g_warning("Failed to write %s: %s", path_.c_str(), error->message);
+  }
+}
+
+bool ReadStateStore::SaveOrdinals() {
+  std::string records = state_.SerializeOrdinals(saved_ordinals_);
+  g_autoptr(GFile) file = g_file_new_for_path(ordinals_path_.c_str());
+  g_autoptr(GError) error = nullptr;
+  g_autoptr(GFileOutputStream) stream =
+      saved_ordinals_ == 0
+          ? g_file_replace(file, nullptr, FALSE, G_FILE_CREATE_PRIVATE,
+                           nullptr, &error)
+          : g_file_append_to(file, G_FILE_CREATE_PRIVATE, nullptr, &error);
+  bool ok = stream != nullptr &&
+            g_output_stream_write_all(G_OUTPUT_STREAM(stream), records.data(),
+                                      records.size(), nullptr, nullptr,
+                                      &error) &&
+            g_output_stream_close(G_OUTPUT_STREAM(stream), nullptr, &error);
+  if (!ok) {
+    g_warning("Failed to write %s: %s", ordinals_path_.c_str(),
+              error->message);
+    // Part of the records may have been written.
+    saved_ordinals_ = 0;
+    return false;
+  }
+  saved_ordinals_ = state_.ordinal_count();
+  return true;
+}
+
+gboolean ReadStateStore::SaveTimeoutCb(gpointer user_data) {
+  ReadStateStore* self = static_cast<ReadStateStore*>(user_data);
+  self->save_source_id_ = 0;
+  self->Save();
+  return G_SOURCE_REMOVE;
+}
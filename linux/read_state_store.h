@@ -0,0 +1,47 @@
+#ifndef FLUTTER_READ_STATE_STORE_H_
+#define FLUTTER_READ_STATE_STORE_H_
+
+#include <glib.h>
+
+#include <string>
+
+#include "read_state.h"
+
+// Owns the ReadState of the signed-in account and persists it under the
+// user data directory: per account, an ordinal log that new hashes are
+// appended to and a file with the read markers.
+class ReadStateStore {
+ public:
+  ReadStateStore();
+  ~ReadStateStore();
+
+  ReadStateStore(const ReadStateStore&) = delete;
+  ReadStateStore& operator=(const ReadStateStore&) = delete;
+
+  // Saves the current account and loads the state of |account|.
+  void Open(const std::string& account);
+
+  // Saves the state a couple of seconds from now, coalescing repeated calls.
+  void ScheduleSave();
+
+  // Writes the state to disk now if it has unsaved changes.
+  void Save();
+
+  ReadState* state() { return &state_; }
+
+ private:
+  static gboolean SaveTimeoutCb(gpointer user_data);
+
+  // Appends the ordinals given out since the last save to the log, or
+  // rewrites the log if it may be damaged.
+  bool SaveOrdinals();
+
+  ReadState state_;
+  std::string path_;
+  std::string ordinals_path_;
+  // Ordinals known to be in the log; 0 means the log is rewritten.
+  uint32_t saved_ordinals_ = 0;
+  guint save_source_id_ = 0;
+};
+
+#endif  // FLUTTER_READ_STATE_STORE_H_
@@ -0,0 +1,419 @@
+#include "roaring_bitmap.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+constexpr size_t kBitmapWords = 65536 / 64;
+
+// Appends |value| to |out| in little-endian order.
+template <typename T>
+void Put(std::string* out, T value) {
+  for (size_t i = 0; i < sizeof(T); i++) {
+    out->push_back(static_cast<char>((static_cast<uint64_t>(value) >> (8 * i)) &
+                                     0xff));
+  }
+}
+
+// Reads a little-endian |T| from [*data, end) into |value|.
+template <typename T>
+bool Get(const char** data, const char* end, T* value) {
+  if (end - *data < static_cast<ptrdiff_t>(sizeof(T))) {
+    return false;
+  }
+  uint64_t result = 0;
+  for (size_t i = 0; i < sizeof(T); i++) {
+    result |= static_cast<uint64_t>(static_cast<uint8_t>((*data)[i])) << (8 * i);
+  }
+  *data += sizeof(T);
+  *value = static_cast<T>(result);
+  return true;
+}
+
+// Sets bits [first, last] of |bitmap| and returns how many were newly set.
+uint32_t SetBits(std::vector<uint64_t>* bitmap, uint32_t first, uint32_t last) {
+  uint32_t added = 0;
+  uint32_t first_word = first / 64;
+  uint32_t last_word = last / 64;
+  for (uint32_t w = first_word; w <= last_word; w++) {
+    uint64_t mask = ~uint64_t(0);
+    if (w == first_word) {
+      mask &= ~uint64_t(0) << (first % 64);
+    }
+    if (w == last_word) {
+      mask &= ~uint64_t(0) >> (63 - last % 64);
+    }
+    uint64_t& word = (*bitmap)[w];
+    added += __builtin_popcountll(mask & ~word);
+    word |= mask;
+  }
+  return added;
+}
+
+}  // namespace
+
+RoaringBitmap::RoaringBitmap() = default;
+
+bool RoaringBitmap::Contains(uint32_t value) const {
+  const Container* container = Find(static_cast<uint16_t>(value >> 16));
+  return container != nullptr &&
+         ContainerContains(*container, static_cast<uint16_t>(value & 0xffff));
+}
+
+bool RoaringBitmap::Add(uint32_t value) {
+  Container* container = FindOrInsert(static_cast<uint16_t>(value >> 16));
+  if (!ContainerAdd(container, static_cast<uint16_t>(value & 0xffff))) {
+    return false;
+  }
+  cardinality_++;
+  return true;
+}
+
+void RoaringBitmap::AddRange(uint32_t first, uint32_t last) {
+  if (first > last) {
+    return;
+  }
+  for (uint32_t key = first >> 16; key <= (last >> 16); key++) {
+    uint32_t chunk_first = key == (first >> 16) ? first & 0xffff : 0;
+    uint32_t chunk_last = key == (last >> 16) ? last & 0xffff : 0xffff;
+    Container* container = FindOrInsert(static_cast<uint16_t>(key));
+    uint32_t before = container->cardinality;
+    ContainerAddRange(container, static_cast<uint16_t>(chunk_first),
+                      static_cast<uint16_t>(chunk_last));
+    cardinality_ += container->cardinality - before;
+    if (key == 0xffff) {
+      break;
+    }
+  }
+}
+
+void RoaringBitmap::Clear() {
+  containers_.clear();
+  cardinality_ = 0;
+}
+
+void RoaringBitmap::Optimize() {
+  for (Container& container : containers_) {
+    Optimize(&container);
+  }
+}
+
+void RoaringBitmap::Serialize(std::string* out) const {
+  Put<uint32_t>(out, static_cast<uint32_t>(containers_.size()));
+  for (const Container& container : containers_) {
+    Put<uint16_t>(out, container.key);
+    Put<uint8_t>(out, static_cast<uint8_t>(container.type));
+    Put<uint32_t>(out, container.cardinality);
+    switch (container.type) {
+      case ContainerType::kArray:
+        Put<uint32_t>(out, static_cast<uint32_t>(container.array.size()));
+        for (uint16_t low : container.array) {
+          Put<uint16_t>(out, low);
+        }
+        break;
+      case ContainerType::kBitmap:
+        Put<uint32_t>(out, static_cast<uint32_t>(container.bitmap.size()));
+        for (uint64_t word : container.bitmap) {
+          Put<uint64_t>(out, word);
+        }
+        break;
+      case ContainerType::kRun:
+        Put<uint32_t>(out, static_cast<uint32_t>(container.runs.size()));
+        for (const auto& run : container.runs) {
+          Put<uint16_t>(out, run.first);
+          Put<uint16_t>(out, run.second);
+        }
+        break;
+    }
+  }
+}
+
+bool RoaringBitmap::Deserialize(const char** data, const char* end) {
+  Clear();
+  uint32_t count = 0;
+  if (!Get(data, end, &count) || count > 65536) {
+    return false;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    Container container;
+    uint8_t type = 0;
+    uint32_t size = 0;
+    if (!Get(data, end, &container.key) || !Get(data, end, &type) ||
+        !Get(data, end, &container.cardinality) || !Get(data, end, &size) ||
+        (!containers_.empty() && containers_.back().key >= container.key)) {
+      Clear();
+      return false;
+    }
+    bool ok = true;
+    switch (static_cast<ContainerType>(type)) {
+      case ContainerType::kArray:
+        container.type = ContainerType::kArray;
+        ok = size <= 65536;
+        container.array.resize(ok ? size : 0);
+        for (uint16_t& low : container.array) {
+          ok = ok && Get(data, end, &low);
+        }
+        break;
+      case ContainerType::kBitmap:
+        container.type = ContainerType::kBitmap;
+        ok = size == kBitmapWords;
+        container.bitmap.resize(ok ? size : 0);
+        for (uint64_t& word : container.bitmap) {
+          ok = ok && Get(data, end, &word);
+        }
+        break;
+      case ContainerType::kRun:
+        container.type = ContainerType::kRun;
+        ok = size <= 32768;
+        container.runs.resize(ok ? size : 0);
+        for (auto& run : container.runs) {
+          ok = ok && Get(data, end, &run.first) && Get(data, end, &run.second);
+        }
+        break;
+      default:
+        ok = false;
+        break;
+    }
+    if (!ok) {
+      Clear();
+      return false;
+    }
+    cardinality_ += container.cardinality;
+    containers_.push_back(std::move(container));
+  }
+  return true;
+}
+
+size_t RoaringBitmap::memory_usage() const {
+  size_t usage = sizeof(*this) + containers_.capacity() * sizeof(Container);
+  for (const Container& container : containers_) {
+    usage += container.array.capacity() * sizeof(uint16_t) +
+             container.bitmap.capacity() * sizeof(uint64_t) +
+             container.runs.capacity() * sizeof(container.runs[0]);
+  }
+  return usage;
+}
+
+RoaringBitmap::Container* RoaringBitmap::Find(uint16_t key) {
+  return const_cast<Container*>(
+      static_cast<const RoaringBitmap*>(this)->Find(key));
+}
+
+const RoaringBitmap::Container* RoaringBitmap::Find(uint16_t key) const {
+  auto it = std::lower_bound(
+      containers_.begin(), containers_.end(), key,
+      [](const Container& container, uint16_t k) { return container.key < k; });
+  return (it != containers_.end() && it->key == key) ? &*it : nullptr;
+}
+
+RoaringBitmap::Container* RoaringBitmap::FindOrInsert(uint16_t key) {
+  auto it = std::lower_bound(
+      containers_.begin(), containers_.end(), key,
+      [](const Container& container, uint16_t k) { return container.key < k; });
+  if (it == containers_.end() || it->key != key) {
+    Container container;
+    container.key = key;
+    it = containers_.insert(it, std::move(container));
+  }
+  return &*it;
+}
+
+bool RoaringBitmap::ContainerContains(const Container& container,
+                                      uint16_t low) {
+  switch (container.type) {
+    case ContainerType::kArray:
+      return std::binary_search(container.array.begin(), container.array.end(),
+                                low);
+    case ContainerType::kBitmap:
+      return (container.bitmap[low / 64] >> (low % 64)) & 1;
+    case ContainerType::kRun: {
+      // First run starting after |low|; the one before it may contain it.
+      auto it = std::upper_bound(
+          container.runs.begin(), container.runs.end(), low,
+          [](uint16_t v, const std::pair<uint16_t, uint16_t>& run) {
+            return v < run.first;
+          });
+      return it != container.runs.begin() && std::prev(it)->second >= low;
+    }
+  }
+  return false;
+}
+
+bool RoaringBitmap::ContainerAdd(Container* container, uint16_t low) {
+  switch (container->type) {
+    case ContainerType::kArray: {
+      auto it = std::lower_bound(container->array.begin(),
+                                 container->array.end(), low);
+      if (it != container->array.end() && *it == low) {
+        return false;
+      }
+      container->array.insert(it, low);
+      container->cardinality++;
+      if (container->cardinality > kMaxArraySize) {
+        ToBitmap(container);
+      }
+      return true;
+    }
+    case ContainerType::kBitmap: {
+      uint64_t& word = container->bitmap[low / 64];
+      uint64_t bit = uint64_t(1) << (low % 64);
+      if (word & bit) {
+        return false;
+      }
+      word |= bit;
+      container->cardinality++;
+      return true;
+    }
+    case ContainerType::kRun:
+      if (ContainerContains(*container, low)) {
+        return false;
+      }
+      ContainerAddRange(container, low, low);
+      return true;
+  }
+  return false;
+}
+
+void RoaringBitmap::ContainerAddRange(Container* container, uint16_t first,
+                                      uint16_t last) {
+  uint32_t length = static_cast<uint32_t>(last) - first + 1;
+  if (container->type == ContainerType::kArray) {
+    if (container->cardinality + length <= kMaxArraySize) {
+      std::vector<uint16_t> range(length);
+      for (uint32_t i = 0; i < length; i++) {
+        range[i] = static_cast<uint16_t>(first + i);
+      }
+      std::vector<uint16_t> merged;
+      merged.reserve(container->array.size() + length);
+      std::set_union(container->array.begin(), container->array.end(),
+                     range.begin(), range.end(), std::back_inserter(merged));
+      container->array = std::move(merged);
+      container->cardinality = static_cast<uint32_t>(container->array.size());
+      return;
+    }
+    // Large ranges are cheapest as a single run.
+    if (container->array.empty()) {
+      container->type = ContainerType::kRun;
+    } else {
+      ToBitmap(container);
+    }
+  }
+
+  if (container->type == ContainerType::kBitmap) {
+    container->cardinality += SetBits(&container->bitmap, first, last);
+    return;
+  }
+
+  // Merge [first, last] with every run it overlaps or touches.
+  std::vector<std::pair<uint16_t, uint16_t>>& runs = container->runs;
+  auto begin = std::lower_bound(
+      runs.begin(), runs.end(), first,
+      [](const std::pair<uint16_t, uint16_t>& run, uint16_t v) {
+        return static_cast<uint32_t>(run.second) + 1 < v;
+      });
+  auto end = begin;
+  uint16_t merged_first = first;
+  uint16_t merged_last = last;
+  while (end != runs.end() && end->first <= static_cast<uint32_t>(last) + 1) {
+    merged_first = std::min(merged_first, end->first);
+    merged_last = std::max(merged_last, end->second);
+    ++end;
+  }
+  auto it = runs.erase(begin, end);
+  runs.insert(it, std::make_pair(merged_first, merged_last));
+
+  uint32_t cardinality = 0;
+  for (const auto& run : runs) {
+    cardinality += static_cast<uint32_t>(run.second) - run.first + 1;
+  }
+  container->cardinality = cardinality;
+  if (runs.size() * 4 > kBitmapWords * 8) {
+    ToBitmap(container);
+  }
+}
+
+void RoaringBitmap::ToBitmap(Container* container) {
+  std::vector<uint64_t> bitmap(kBitmapWords, 0);
+  if (container->type == ContainerType::kArray) {
+    for (uint16_t low : container->array) {
+      bitmap[low / 64] |= uint64_t(1) << (low % 64);
+    }
+  } else if (container->type == ContainerType::kRun) {
+    for (const auto& run : container->runs) {
+      SetBits(&bitmap, run.first, run.second);
+    }
+  } else {
+    return;
+  }
+  container->array.clear();
+  container->array.shrink_to_fit();
+  container->runs.clear();
+  container->runs.shrink_to_fit();
+  container->bitmap = std::move(bitmap);
+  container->type = ContainerType::kBitmap;
+}
+
+void RoaringBitmap::Optimize(Container* container) {
+  // Collect the runs of the container, whatever its current form.
+  std::vector<std::pair<uint16_t, uint16_t>> runs;
+  auto extend = [&runs](uint32_t low) {
+    if (!runs.empty() && static_cast<uint32_t>(runs.back().second) + 1 == low) {
+      runs.back().second = static_cast<uint16_t>(low);
+    } else {
+      runs.emplace_back(static_cast<uint16_t>(low), static_cast<uint16_t>(low));
+    }
+  };
+  switch (container->type) {
+    case ContainerType::kArray:
+      for (uint16_t low : container->array) {
+        extend(low);
+      }
+      break;
+    case ContainerType::kBitmap:
+      for (uint32_t w = 0; w < kBitmapWords; w++) {
+        uint64_t word = container->bitmap[w];
+        while (word != 0) {
+          uint32_t bit = __builtin_ctzll(word);
+          extend(w * 64 + bit);
+          word &= word - 1;
+        }
+      }
+      break;
+    case ContainerType::kRun:
+      runs = container->runs;
+      break;
+  }
+
+  size_t run_bytes = runs.size() * 4;
+  size_t array_bytes = container->cardinality <= kMaxArraySize
+                           ? container->cardinality * 2
+                           : SIZE_MAX;
+  size_t bitmap_bytes = kBitmapWords * 8;
+
+  std::vector<uint16_t> array;
+  if (run_bytes <= array_bytes && run_bytes <= bitmap_bytes) {
+    container->type = ContainerType::kRun;
+    container->runs = std::move(runs);
+    container->array.clear();
+    container->bitmap.clear();
+  } else if (array_bytes <= bitmap_bytes) {
+    array.reserve(container->cardinality);
+    for (const auto& run : runs) {
+      for (uint32_t low = run.first; low <= run.second; low++) {
+        array.push_back(static_cast<uint16_t>(low));
+      }
+    }
+    container->type = ContainerType::kArray;
+    container->array = std::move(array);
+    container->runs.clear();
+    container->bitmap.clear();
+  } else if (container->type != ContainerType::kBitmap) {
+    container->runs = std::move(runs);
+    container->type = ContainerType::kRun;
+    ToBitmap(container);
+  }
+  container->array.shrink_to_fit();
+  container->bitmap.shrink_to_fit();
+  container->runs.shrink_to_fit();
+}
@@ -0,0 +1,80 @@
+#ifndef FLUTTER_ROARING_BITMAP_H_
+#define FLUTTER_ROARING_BITMAP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// A compressed set of 32-bit integers in the style of Roaring bitmaps. Values
+// are split into 2^16-wide chunks by their high 16 bits, and each chunk is
+// stored as whichever of a sorted array, a dense bitmap or a list of runs is
+// smallest for it.
+class RoaringBitmap {
+ public:
+  RoaringBitmap();
+
+  bool Contains(uint32_t value) const;
+
+  // Adds |value| and returns true if it was not in the set already.
+  bool Add(uint32_t value);
+
+  // Adds every value in [first, last].
+  void AddRange(uint32_t first, uint32_t last);
+
+  // Number of values in the set.
+  uint64_t Cardinality() const { return cardinality_; }
+
+  void Clear();
+
+  // Converts each chunk to its most compact representation.
+  void Optimize();
+
+  // Appends a portable encoding of the set to |out|.
+  void Serialize(std::string* out) const;
+
+  // Replaces the set with one decoded from [*data, end) and advances |*data|
+  // past it. Returns false and leaves the set empty on malformed input.
+  bool Deserialize(const char** data, const char* end);
+
+  // Approximate heap usage.
+  size_t memory_usage() const;
+
+ private:
+  enum class ContainerType : uint8_t { kArray = 0, kBitmap = 1, kRun = 2 };
+
+  // Values sharing the high 16 bits |key|.
+  struct Container {
+    uint16_t key = 0;
+    ContainerType type = ContainerType::kArray;
+    uint32_t cardinality = 0;
+    // kArray: sorted low bits.
+    std::vector<uint16_t> array;
+    // kBitmap: 1024 words covering the whole chunk.
+    std::vector<uint64_t> bitmap;
+    // kRun: sorted, non-adjacent [start, last] intervals.
+    std::vector<std::pair<uint16_t, uint16_t>> runs;
+  };
+
+  // Arrays are converted to bitmaps past this many values, where the bitmap
+  // (8 KiB) becomes the smaller of the two.
+  static constexpr uint32_t kMaxArraySize = 4096;
+
+  Container* Find(uint16_t key);
+  const Container* Find(uint16_t key) const;
+  Container* FindOrInsert(uint16_t key);
+
+  static bool ContainerContains(const Container& container, uint16_t low);
+  static bool ContainerAdd(Container* container, uint16_t low);
+  static void ContainerAddRange(Container* container, uint16_t first,
+                                uint16_t last);
+  static void ToBitmap(Container* container);
+  static void Optimize(Container* container);
+
+  // Sorted by key.
+  std::vector<Container> containers_;
+  uint64_t cardinality_ = 0;
+};
+
+#endif  // FLUTTER_ROARING_BITMAP_H_
@@ -0,0 +1,210 @@
+#include "sync_engine.h"
+
+#include "json_reader.h"
+
+namespace {
+
+constexpr long kTimeoutSeconds = 60;
+
+// How much of an error response is kept for the error message.
+constexpr size_t kMaxErrorBody = 1024;
+
+constexpr char kWhitespace[] = " \t\r\n";
+
+// Returns |value| as a JSON string literal.
+std::string JsonQuote(const std::string& value) {
+  static const char kHex[] = "0123456789abcdef";
+  std::string quoted = "\"";
+  for (char c : value) {
+    switch (c) {
+      case '"':
+        quoted += "\\\"";
+        break;
+      case '\\':
+        quoted += "\\\\";
+        break;
+      case '\n':
+        quoted += "\\n";
+        break;
+      case '\r':
+        quoted += "\\r";
+        break;
+      case '\t':
+        quoted += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          quoted += "\\u00";
+          quoted += kHex[(c >> 4) & 0xf];
+          quoted += kHex[c & 0xf];
+        } else {
+          quoted += c;
+        }
+        break;
+    }
+  }
+  return quoted + "\"";
+}
+
+// Returns |value| without leading or trailing ASCII whitespace.
+std::string Trim(const std::string& value) {
+  size_t first = value.find_first_not_of(kWhitespace);
+  if (first == std::string::npos) {
+    return std::string();
+  }
+  return value.substr(first, value.find_last_not_of(kWhitespace) + 1 - first);
+}
+
+}  // namespace
+
+struct SyncEngine::Transfer {
+  CURL* curl;
+  const Sink* sink;
+  // Set by the first write once the status is known.
+  bool checked_status = false;
+  bool ok = false;
+  std::string error_body;
+};
+
+SyncEngine::SyncEngine(const std::string& server)
+    : curl_(curl_easy_init()), server_(NormalizeServer(server)) {}
+
+SyncEngine::~SyncEngine() {
+  if (curl_ != nullptr) {
+    curl_easy_cleanup(curl_);
+  }
+}
+
+std::string SyncEngine::NormalizeServer(const std::string& server) {
+  std::string normalized = Trim(server);
+  while (!normalized.empty() && normalized.back() == '/') {
+    normalized.pop_back();
+  }
+  return normalized;
+}
+
+std::string SyncEngine::AccountKey(const std::string& username,
+                                   const std::string& server) {
+  return Trim(username) + "@" + NormalizeServer(server);
+}
+
+bool SyncEngine::Login(const std::string& username,
+                       const std::string& password, std::string* error) {
+  std::string response;
+  std::string body = "{\"username\":" + JsonQuote(username) +
+                     ",\"password\":" + JsonQuote(password) + "}";
+  Sink sink = [&response](const char* data, size_t size) {
+    response.append(data, size);
+    return true;
+  };
+  if (!Post("auth", body, "application/json", sink, error)) {
+    return false;
+  }
+
+  std::string token;
+  JsonReader reader(response);
+  bool ok = reader.ReadObject([&](const std::string& key) {
+    return key == "token" ? reader.ReadStringOrSkip(&token)
+                          : reader.SkipValue();
+  });
+  if (!ok || token.empty()) {
+    *error = "Token not found in response.";
+    return false;
+  }
+  token_ = token;
+  return true;
+}
+
+bool SyncEngine::FetchTimeline(const std::string& endpoint, std::string* body,
+                               std::string* error) {
+  body->clear();
+  return FetchTimeline(
+      endpoint,
+      [body](const char* data, size_t size) {
+        body->append(data, size);
+        return true;
+      },
+      error);
+}
+
+bool SyncEngine::FetchTimeline(const std::string& endpoint, const Sink& sink,
+                               std::string* error) {
+  // Matches the GUI, which sends an empty JSON object as a form body.
+  return Post(endpoint, "{}", "application/x-www-form-urlencoded", sink,
+              error);
+}
+
+bool SyncEngine::Post(const std::string& path, const std::string& body,
+                      const char* content_type, const Sink& sink,
+                      std::string* error) {
+  if (curl_ == nullptr) {
+    *error = "Failed to initialize libcurl";
+    return false;
+  }
+
+  std::string url = server_ + "/api/v1/" + path;
+  std::string content_type_header = std::string("Content-Type: ") + content_type;
+  std::string token_header = "token: " + token_;
+  struct curl_slist* headers =
+      curl_slist_append(nullptr, content_type_header.c_str());
+  if (!token_.empty()) {
+    headers = curl_slist_append(headers, token_header.c_str());
+  }
+
+  Transfer transfer{curl_, &sink};
+  wire_bytes_ = 0;
+  curl_easy_reset(curl_);
+  curl_easy_setopt(curl_, CURLOPT_URL, url.c_str());
+  curl_easy_setopt(curl_, CURLOPT_HTTPHEADER, headers);
+  curl_easy_setopt(curl_, CURLOPT_POSTFIELDS, body.c_str());
+  curl_easy_setopt(curl_, CURLOPT_POSTFIELDSIZE, static_cast<long>(body.size()));
+  curl_easy_setopt(curl_, CURLOPT_WRITEFUNCTION, WriteCb);
+  curl_easy_setopt(curl_, CURLOPT_WRITEDATA, &transfer);
+  // An empty string advertises every encoding libcurl can decode.
+  curl_easy_setopt(curl_, CURLOPT_ACCEPT_ENCODING, "");
+  curl_easy_setopt(curl_, CURLOPT_FOLLOWLOCATION, 1L);
+  curl_easy_setopt(curl_, CURLOPT_TIMEOUT, kTimeoutSeconds);
+  curl_easy_setopt(curl_, CURLOPT_NOSIGNAL, 1L);
+
+  CURLcode result = curl_easy_perform(curl_);
+  curl_slist_free_all(headers);
+  curl_off_t downloaded = 0;
+  if (curl_easy_getinfo(curl_, CURLINFO_SIZE_DOWNLOAD_T, &downloaded) ==
+      CURLE_OK) {
+    wire_bytes_ = downloaded;
+  }
+
+  long status = 0;
+  curl_easy_getinfo(curl_, CURLINFO_RESPONSE_CODE, &status);
+  if (status != 0 && status != 200) {
+    *error = "HTTP " + std::to_string(status) + " from " + url;
+    if (transfer.error_body.compare(0, 19, "Invalid Credentials") == 0) {
+      *error = "Invalid credentials!";
+    }
+    return false;
+  }
+  if (result != CURLE_OK) {
+    *error = curl_easy_strerror(result);
+    return false;
+  }
+  return true;
+}
+
+size_t SyncEngine::WriteCb(char* data, size_t size, size_t count,
+                           void* user_data) {
+  Transfer* transfer = static_cast<Transfer*>(user_data);
+  size_t length = size * count;
+  if (!transfer->checked_status) {
+    long status = 0;
+    curl_easy_getinfo(transfer->curl, CURLINFO_RESPONSE_CODE, &status);
+    transfer->checked_status = true;
+    transfer->ok = status == 200;
+  }
+  if (!transfer->ok) {
+    // Error bodies are only kept for the message, never passed on.
+    size_t room = kMaxErrorBody - transfer->error_body.size();
+    transfer->error_body.append(data, length < room ? length : room);
+    return length;
+  }
+  return (*transfer->sink)(data, length) ? length : 0;
+}
@@ -0,0 +1,74 @@
+#ifndef FLUTTER_SYNC_ENGINE_H_
+#define FLUTTER_SYNC_ENGINE_H_
+
+#include <curl/curl.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// Talks to a yarn.social pod's API with blocking requests. Used by the
+// headless mode, which has no Dart side to do the networking, and on a
+// worker thread to stream timelines to the GUI.
+//
+// Every encoding libcurl was built with (gzip, and usually brotli and zstd)
+// is advertised; responses are decompressed as they arrive.
+class SyncEngine {
+ public:
+  // Receives the decompressed response body piece by piece. Returning false
+  // aborts the transfer.
+  using Sink = std::function<bool(const char* data, size_t size)>;
+
+  // |server| is the pod's base URL, e.g. "https://twtxt.net".
+  explicit SyncEngine(const std::string& server);
+  ~SyncEngine();
+
+  SyncEngine(const SyncEngine&) = delete;
+  SyncEngine& operator=(const SyncEngine&) = delete;
+
+  // Returns |server| without surrounding whitespace or trailing slashes, the
+  // form API URLs and account keys are built from.
+  static std::string NormalizeServer(const std::string& server);
+
+  // Key of |username|'s account on |server|, under which the GUI and
+  // headless runs share the timeline cache and read state.
+  static std::string AccountKey(const std::string& username,
+                                const std::string& server);
+
+  // Authenticates and keeps the token for later requests.
+  bool Login(const std::string& username, const std::string& password,
+             std::string* error);
+
+  // Uses a token obtained elsewhere, e.g. by the GUI, instead of Login().
+  void set_token(const std::string& token) { token_ = token; }
+
+  // Fetches the raw JSON of |endpoint| ("discover", "timeline" or
+  // "mentions") into |body|.
+  bool FetchTimeline(const std::string& endpoint, std::string* body,
+                     std::string* error);
+
+  // Like FetchTimeline(), but passes the JSON to |sink| as it arrives.
+  bool FetchTimeline(const std::string& endpoint, const Sink& sink,
+                     std::string* error);
+
+  // Body bytes of the last response as sent by the pod, i.e. before
+  // decompression.
+  int64_t wire_bytes() const { return wire_bytes_; }
+
+ private:
+  struct Transfer;
+
+  // POSTs |body| to |path| under the API root and passes the response body
+  // to |sink|. Fails unless the status is 200.
+  bool Post(const std::string& path, const std::string& body,
+            const char* content_type, const Sink& sink, std::string* error);
+
+  static size_t WriteCb(char* data, size_t size, size_t count, void* user_data);
+
+  CURL* curl_;
+  std::string server_;
+  std::string token_;
+  int64_t wire_bytes_ = 0;
+};
+
+#endif  // FLUTTER_SYNC_ENGINE_H_
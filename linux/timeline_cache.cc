@@ -0,0 +1,114 @@
+#include "timeline_cache.h"
+
+#include <glib.h>
+
+TimelineCache::Writer::Writer(GFileOutputStream* stream)
+    : stream_(stream), cancellable_(g_cancellable_new()) {}
+
+TimelineCache::Writer::~Writer() {
+  if (!g_output_stream_is_closed(G_OUTPUT_STREAM(stream_))) {
+    // Closing a cancelled stream leaves the previous file in place.
+    g_cancellable_cancel(cancellable_);
+    g_output_stream_close(G_OUTPUT_STREAM(stream_), cancellable_, nullptr);
+  }
+  g_object_unref(stream_);
+  g_object_unref(cancellable_);
+}
+
+bool TimelineCache::Writer::Append(const char* data, size_t size) {
+  g_autoptr(GError) error = nullptr;
+  if (ok_ && !g_output_stream_write_all(G_OUTPUT_STREAM(stream_), data, size,
+                                        nullptr, cancellable_, &error)) {
+    g_warning("Failed to write the timeline cache: %s", error->message);
+    ok_ = false;
+  }
+  return ok_;
+}
+
+bool TimelineCache::Writer::Commit() {
+  if (!ok_) {
+    return false;
+  }
+  g_autoptr(GError) error = nullptr;
+  if (!g_output_stream_close(G_OUTPUT_STREAM(stream_), cancellable_,
+                             &error)) {
+    g_warning("Failed to write the timeline cache: %s", error->message);
+    return false;
+  }
+  return true;
+}
+
+TimelineCache::TimelineCache(const std::string& account) {
+  g_autofree gchar* digest =
+      g_compute_checksum_for_string(G_CHECKSUM_SHA256, account.c_str(), -1);
+  g_autofree gchar* dir = g_build_filename(
+      g_get_user_cache_dir(), "yarndesktopclient", digest, nullptr);
+  dir_ = dir;
+}
+
+bool TimelineCache::IsValidEndpoint(const std::string& endpoint) {
+  return endpoint == "discover" || endpoint == "timeline" ||
+         endpoint == "mentions";
+}
+
+bool TimelineCache::Read(const std::string& endpoint, std::string* body) const {
+  if (!IsValidEndpoint(endpoint)) {
+    return false;
+  }
+  g_autofree gchar* contents = nullptr;
+  gsize length = 0;
+  if (!g_file_get_contents(PathFor(endpoint).c_str(), &contents, &length,
+                           nullptr)) {
+    return false;
+  }
+  body->assign(contents, length);
+  return true;
+}
+
+bool TimelineCache::Write(const std::string& endpoint,
+                          const std::string& body) const {
+  if (!IsValidEndpoint(endpoint)) {
+    return false;
+  }
+  if (!EnsureDir()) {
+    return false;
+  }
+  std::string path = PathFor(endpoint);
+  g_autoptr(GError) error = nullptr;
+  if (!g_file_set_contents(path.c_str(), body.data(),
+                           static_cast<gssize>(body.size()), &error)) {
+    g_warning("Failed to write %s: %s", path.c_str(), error->message);
+    return false;
+  }
+  return true;
+}
+
+std::unique_ptr<TimelineCache::Writer> TimelineCache::BeginWrite(
+    const std::string& endpoint) const {
+  if (!IsValidEndpoint(endpoint) || !EnsureDir()) {
+    return nullptr;
+  }
+  g_autoptr(GFile) file = g_file_new_for_path(PathFor(endpoint).c_str());
+  g_autoptr(GError) error = nullptr;
+  GFileOutputStream* stream = g_file_replace(
+      file, nullptr, FALSE, G_FILE_CREATE_PRIVATE, nullptr, &error);
+  if (stream == nullptr) {
+    g_warning("Failed to write the timeline cache: %s", error->message);
+    return nullptr;
+  }
+  return std::unique_ptr<Writer>(new Writer(stream));
+}
+
+std::string TimelineCache::PathFor(const std::string& endpoint) const {
+  g_autofree gchar* name = g_strconcat(endpoint.c_str(), ".json", nullptr);
+  g_autofree gchar* path = g_build_filename(dir_.c_str(), name, nullptr);
+  return path;
+}
+
+bool TimelineCache::EnsureDir() const {
+  if (g_mkdir_with_parents(dir_.c_str(), 0700) != 0) {
+    g_warning("Failed to create %s", dir_.c_str());
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,62 @@
+#ifndef FLUTTER_TIMELINE_CACHE_H_
+#define FLUTTER_TIMELINE_CACHE_H_
+
+#include <gio/gio.h>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+// The last fetched JSON of each timeline of an account, kept under the user
+// cache directory so the GUI can show something before the pod answers and
+// headless runs can refresh it from cron.
+class TimelineCache {
+ public:
+  // Writes a new cached JSON piece by piece. The previous one is kept until
+  // Commit() succeeds, so an aborted download never truncates the cache.
+  class Writer {
+   public:
+    ~Writer();
+
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    bool Append(const char* data, size_t size);
+
+    // Replaces the cached JSON with everything appended.
+    bool Commit();
+
+   private:
+    friend class TimelineCache;
+
+    explicit Writer(GFileOutputStream* stream);
+
+    GFileOutputStream* stream_;
+    GCancellable* cancellable_;
+    bool ok_ = true;
+  };
+
+  // |account| identifies the account, see SyncEngine::AccountKey().
+  explicit TimelineCache(const std::string& account);
+
+  // True for the endpoints that are cached.
+  static bool IsValidEndpoint(const std::string& endpoint);
+
+  // Reads the cached JSON of |endpoint| into |body|.
+  bool Read(const std::string& endpoint, std::string* body) const;
+
+  // Replaces the cached JSON of |endpoint| with |body|.
+  bool Write(const std::string& endpoint, const std::string& body) const;
+
+  // Starts replacing the cached JSON of |endpoint|, or returns null.
+  std::unique_ptr<Writer> BeginWrite(const std::string& endpoint) const;
+
+ private:
+  std::string PathFor(const std::string& endpoint) const;
+
+  bool EnsureDir() const;
+
+  std::string dir_;
+};
+
+#endif  // FLUTTER_TIMELINE_CACHE_H_
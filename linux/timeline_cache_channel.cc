@@ -0,0 +1,78 @@
+#include "timeline_cache_channel.h"
+
+#include <cstring>
+#include <string>
+
+#include "sync_engine.h"
+#include "timeline_cache.h"
+
+namespace {
+
+std::string LookupString(FlValue* map, const char* key) {
+  FlValue* value = fl_value_lookup_string(map, key);
+  if (value == nullptr || fl_value_get_type(value) != FL_VALUE_TYPE_STRING) {
+    return std::string();
+  }
+  return fl_value_get_string(value);
+}
+
+FlMethodResponse* AccountKey(FlValue* args) {
+  g_autoptr(FlValue) result = fl_value_new_string(
+      SyncEngine::AccountKey(LookupString(args, "username"),
+                             LookupString(args, "server"))
+          .c_str());
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+FlMethodResponse* ReadTimeline(FlValue* args) {
+  TimelineCache cache(LookupString(args, "account"));
+  std::string body;
+  g_autoptr(FlValue) result =
+      cache.Read(LookupString(args, "endpoint"), &body)
+          ? fl_value_new_string_sized(body.data(), body.size())
+          : fl_value_new_null();
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+FlMethodResponse* WriteTimeline(FlValue* args) {
+  TimelineCache cache(LookupString(args, "account"));
+  g_autoptr(FlValue) result = fl_value_new_bool(cache.Write(
+      LookupString(args, "endpoint"), LookupString(args, "body")));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+void method_call_cb(FlMethodChannel* channel, FlMethodCall* method_call,
+                    gpointer user_data) {
+  const gchar* method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+
+  g_autoptr(FlMethodResponse) response = nullptr;
+  if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
+    response = FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "bad-args", "Expected a map of arguments", nullptr));
+  } else if (strcmp(method, "accountKey") == 0) {
+    response = AccountKey(args);
+  } else if (strcmp(method, "readTimeline") == 0) {
+    response = ReadTimeline(args);
+  } else if (strcmp(method, "writeTimeline") == 0) {
+    response = WriteTimeline(args);
+  } else {
+    response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
+  }
+
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond(method_call, response, &error)) {
+    g_warning("Failed to send cache response: %s", error->message);
+  }
+}
+
+}  // namespace
+
+FlMethodChannel* timeline_cache_channel_new(FlBinaryMessenger* messenger) {
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  FlMethodChannel* channel = fl_method_channel_new(
+      messenger, "yarndesktopclient/cache", FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(channel, method_call_cb, nullptr,
+                                            nullptr);
+  return channel;
+}
@@ -0,0 +1,19 @@
+#ifndef FLUTTER_TIMELINE_CACHE_CHANNEL_H_
+#define FLUTTER_TIMELINE_CACHE_CHANNEL_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+/**
+ * timeline_cache_channel_new:
+ * @messenger: an #FlBinaryMessenger.
+ *
+ * Creates the "yarndesktopclient/cache" method channel, which handles:
+ *  - readTimeline({account, endpoint}): returns the cached JSON or null.
+ *  - writeTimeline({account, endpoint, body}): replaces the cached JSON.
+ * The cache is shared with `--headless` runs.
+ *
+ * Returns: a new #FlMethodChannel.
+ */
+FlMethodChannel* timeline_cache_channel_new(FlBinaryMessenger* messenger);
+
+#endif  // FLUTTER_TIMELINE_CACHE_CHANNEL_H_
@@ -0,0 +1,194 @@
+#include "timeline_transport_channel.h"
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "sync_engine.h"
+#include "timeline_cache.h"
+#include "twt_stream.h"
+
+namespace {
+
+// Rows in the first batch, about a screenful, so it is sent early.
+constexpr size_t kFirstBatchRows = 20;
+constexpr size_t kBatchRows = 250;
+
+// One fetchTimeline call. Owned by the worker thread until it hands it back
+// to the main thread in fetch_done_cb().
+struct Fetch {
+  FlMethodChannel* channel;
+  FlMethodCall* method_call;
+  int64_t id;
+  std::string server;
+  std::string token;
+  std::string endpoint;
+  std::string account;
+
+  // Rows not sent in a batch yet.
+  std::vector<std::string> rows;
+  bool ok = false;
+  std::string error;
+  int64_t wire_bytes = 0;
+  size_t row_count = 0;
+};
+
+struct Batch {
+  FlMethodChannel* channel;
+  int64_t id;
+  std::vector<std::string> rows;
+};
+
+std::string LookupString(FlValue* map, const char* key) {
+  FlValue* value = fl_value_lookup_string(map, key);
+  if (value == nullptr || fl_value_get_type(value) != FL_VALUE_TYPE_STRING) {
+    return std::string();
+  }
+  return fl_value_get_string(value);
+}
+
+FlValue* RowsValue(const std::vector<std::string>& rows) {
+  FlValue* list = fl_value_new_list();
+  for (const std::string& row : rows) {
+    fl_value_append_take(list,
+                         fl_value_new_string_sized(row.data(), row.size()));
+  }
+  return list;
+}
+
+// Runs on the main thread; batches are dispatched in the order they were
+// queued, and before the fetch_done_cb() queued after them.
+gboolean send_batch_cb(gpointer user_data) {
+  std::unique_ptr<Batch> batch(static_cast<Batch*>(user_data));
+  g_autoptr(FlValue) args = fl_value_new_map();
+  fl_value_set_string_take(args, "id", fl_value_new_int(batch->id));
+  fl_value_set_string_take(args, "twts", RowsValue(batch->rows));
+  fl_method_channel_invoke_method(batch->channel, "timelineRows", args,
+                                  nullptr, nullptr, nullptr);
+  g_object_unref(batch->channel);
+  return G_SOURCE_REMOVE;
+}
+
+gboolean fetch_done_cb(gpointer user_data) {
+  std::unique_ptr<Fetch> fetch(static_cast<Fetch*>(user_data));
+  g_autoptr(FlMethodResponse) response = nullptr;
+  if (fetch->ok) {
+    g_autoptr(FlValue) result = fl_value_new_map();
+    fl_value_set_string_take(result, "twts", RowsValue(fetch->rows));
+    fl_value_set_string_take(
+        result, "rows", fl_value_new_int(static_cast<int64_t>(fetch->row_count)));
+    fl_value_set_string_take(result, "wireBytes",
+                             fl_value_new_int(fetch->wire_bytes));
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+  } else {
+    response = FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "fetch-failed", fetch->error.c_str(), nullptr));
+  }
+
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond(fetch->method_call, response, &error)) {
+    g_warning("Failed to send transport response: %s", error->message);
+  }
+  g_object_unref(fetch->method_call);
+  g_object_unref(fetch->channel);
+  return G_SOURCE_REMOVE;
+}
+
+gpointer fetch_thread(gpointer user_data) {
+  Fetch* fetch = static_cast<Fetch*>(user_data);
+
+  std::unique_ptr<TimelineCache::Writer> cache;
+  if (!fetch->account.empty()) {
+    cache = TimelineCache(fetch->account).BeginWrite(fetch->endpoint);
+  }
+
+  size_t batch_rows = kFirstBatchRows;
+  TwtStream stream([&](const char* data, size_t size) {
+    fetch->rows.emplace_back(data, size);
+    if (fetch->rows.size() >= batch_rows) {
+      g_idle_add(send_batch_cb,
+                 new Batch{FL_METHOD_CHANNEL(g_object_ref(fetch->channel)),
+                           fetch->id, std::move(fetch->rows)});
+      fetch->rows.clear();
+      batch_rows = kBatchRows;
+    }
+  });
+
+  SyncEngine engine(fetch->server);
+  engine.set_token(fetch->token);
+  bool parsed = true;
+  fetch->ok = engine.FetchTimeline(
+      fetch->endpoint,
+      [&](const char* data, size_t size) {
+        if (cache) {
+          cache->Append(data, size);
+        }
+        parsed = stream.Feed(data, size);
+        return parsed;
+      },
+      &fetch->error);
+  if (!parsed || (fetch->ok && !stream.done())) {
+    fetch->ok = false;
+    fetch->error = "Malformed timeline response.";
+  }
+  if (fetch->ok && cache) {
+    cache->Commit();
+  }
+  fetch->wire_bytes = engine.wire_bytes();
+  fetch->row_count = stream.twt_count();
+
+  g_idle_add(fetch_done_cb, fetch);
+  return nullptr;
+}
+
+void FetchTimeline(FlMethodChannel* channel, FlMethodCall* method_call,
+                   FlValue* args) {
+  FlValue* id = fl_value_lookup_string(args, "id");
+  Fetch* fetch = new Fetch();
+  fetch->channel = FL_METHOD_CHANNEL(g_object_ref(channel));
+  fetch->method_call = FL_METHOD_CALL(g_object_ref(method_call));
+  fetch->id = id != nullptr && fl_value_get_type(id) == FL_VALUE_TYPE_INT
+                  ? fl_value_get_int(id)
+                  : 0;
+  fetch->server = LookupString(args, "server");
+  fetch->token = LookupString(args, "token");
+  fetch->endpoint = LookupString(args, "endpoint");
+  fetch->account = LookupString(args, "account");
+  g_thread_unref(g_thread_new("timeline-fetch", fetch_thread, fetch));
+}
+
+void method_call_cb(FlMethodChannel* channel, FlMethodCall* method_call,
+                    gpointer user_data) {
+  const gchar* method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+
+  g_autoptr(FlMethodResponse) response = nullptr;
+  if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
+    response = FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "bad-args", "Expected a map of arguments", nullptr));
+  } else if (strcmp(method, "fetchTimeline") == 0) {
+    // Responds from the worker once the fetch is done.
+    FetchTimeline(channel, method_call, args);
+    return;
+  } else {
+    response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
+  }
+
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond(method_call, response, &error)) {
+    g_warning("Failed to send transport response: %s", error->message);
+  }
+}
+
+}  // namespace
+
+FlMethodChannel* timeline_transport_channel_new(FlBinaryMessenger* messenger) {
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  FlMethodChannel* channel = fl_method_channel_new(
+      messenger, "yarndesktopclient/transport", FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(channel, method_call_cb, nullptr,
+                                            nullptr);
+  return channel;
+}
@@ -0,0 +1,23 @@
+#ifndef FLUTTER_TIMELINE_TRANSPORT_CHANNEL_H_
+#define FLUTTER_TIMELINE_TRANSPORT_CHANNEL_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+/**
+ * timeline_transport_channel_new:
+ * @messenger: an #FlBinaryMessenger.
+ *
+ * Creates the "yarndesktopclient/transport" method channel, which handles
+ * fetchTimeline({id, server, token, endpoint, account}). The timeline is
+ * fetched with compression on a worker thread and split into twts as it is
+ * decompressed. The first twts reach Dart early through
+ * timelineRows({id, twts}) calls on the same channel. The call itself
+ * returns {twts, rows, wireBytes}, where twts holds the rows not sent yet.
+ * Each twt is sent as its JSON text. If @account is given, the response
+ * also replaces the cached timeline.
+ *
+ * Returns: a new #FlMethodChannel.
+ */
+FlMethodChannel* timeline_transport_channel_new(FlBinaryMessenger* messenger);
+
+#endif  // FLUTTER_TIMELINE_TRANSPORT_CHANNEL_H_
@@ -0,0 +1,395 @@
+// Measures what compression and streaming buy when fetching a large
+// discover page. A mock pod on localhost serves a synthetic page, paced to
+// a given link speed, in each encoding it can produce. The page is fetched
+// with SyncEngine in two ways:
+//  - buffered: the whole body is received, then parsed with JsonReader;
+//  - streamed: the body is split into twts by TwtStream as it arrives.
+// For each run it reports the bytes on the wire, the time to the first row
+// and the most body bytes held in memory at once.
+//
+// Usage: transport_benchmark [--twts N] [--kbps N] [--runs N]
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#ifdef HAVE_BROTLI
+#include <brotli/encode.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "json_reader.h"
+#include "sync_engine.h"
+#include "twt_stream.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double MillisecondsSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+// A page of |count| twts shaped like a pod's /api/v1/discover response.
+std::string MakeDiscoverPage(int count) {
+  static const char* kWords[] = {
+      "the",     "a",       "yarn",   "twtxt",   "pod",     "feed",
+      "today",   "just",    "really", "think",   "about",   "with",
+      "release", "server",  "client", "weekend", "coffee",  "music",
+      "linux",   "flutter", "build",  "working", "finally", "nice",
+      "thanks",  "reply",   "thread", "going",   "people",  "post",
+  };
+  constexpr int kWordCount = sizeof(kWords) / sizeof(kWords[0]);
+  constexpr int kFeeds = 200;
+
+  std::mt19937 rng(42);
+  auto feed_uri = [](int feed) {
+    return "https://pod" + std::to_string(feed % 7) + ".example/user/user" +
+           std::to_string(feed) + "/twtxt.txt";
+  };
+  auto hash = [&rng]() {
+    static const char kBase32[] = "abcdefghijklmnopqrstuvwxyz234567";
+    std::string value;
+    for (int i = 0; i < 7; i++) {
+      value += kBase32[rng() % 32];
+    }
+    return value;
+  };
+
+  std::string page = "{\"twts\":[";
+  for (int i = 0; i < count; i++) {
+    int feed = static_cast<int>(rng() % kFeeds);
+    std::string nick = "user" + std::to_string(feed);
+    std::string twt_hash = hash();
+    std::string subject = "#" + hash();
+    std::string text = "(" + subject + ") ";
+    std::string mentions;
+    int words = 10 + static_cast<int>(rng() % 50);
+    for (int w = 0; w < words; w++) {
+      if (rng() % 40 == 0) {
+        int other = static_cast<int>(rng() % kFeeds);
+        text += "@<user" + std::to_string(other) + " " + feed_uri(other) + "> ";
+        mentions += std::string(mentions.empty() ? "" : ",") + "\"" +
+                    feed_uri(other) + "\"";
+      } else {
+        text += kWords[rng() % kWordCount];
+        text += ' ';
+      }
+    }
+    if (rng() % 10 == 0) {
+      text += "![](https://pod0.example/media/" + hash() + ".png)";
+    }
+
+    page += i == 0 ? "{" : ",{";
+    page += "\"twter\":{\"nick\":\"" + nick + "\",\"uri\":\"" + feed_uri(feed) +
+            "\",\"avatar\":\"https://pod" + std::to_string(feed % 7) +
+            ".example/user/" + nick + "/avatar#" + hash() + "\"},";
+    page += "\"text\":\"" + text + "\",";
+    page += "\"markdownText\":\"" + text + "\",";
+    page += "\"created\":\"2024-05-" + std::to_string(10 + i % 18) + "T" +
+            std::to_string(10 + i % 12) + ":" + std::to_string(10 + i % 50) +
+            ":00Z\",";
+    page += "\"hash\":\"" + twt_hash + "\",";
+    page += "\"subject\":\"(" + subject + ")\",";
+    page += "\"mentions\":[" + mentions + "],\"tags\":[],\"links\":[]}";
+  }
+  page += "],\"pager\":{\"current_page\":1,\"max_pages\":1,\"total_twts\":" +
+          std::to_string(count) + "}}";
+  return page;
+}
+
+std::string Gzip(const std::string& data) {
+  z_stream stream = {};
+  // 16 + MAX_WBITS asks for a gzip header rather than a zlib one.
+  deflateInit2(&stream, 6, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+  std::string out(deflateBound(&stream, data.size()), '\0');
+  stream.next_in =
+      reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  stream.avail_in = static_cast<uInt>(data.size());
+  stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+  stream.avail_out = static_cast<uInt>(out.size());
+  deflate(&stream, Z_FINISH);
+  out.resize(stream.total_out);
+  deflateEnd(&stream);
+  return out;
+}
+
+#ifdef HAVE_BROTLI
+std::string Brotli(const std::string& data) {
+  size_t size = BrotliEncoderMaxCompressedSize(data.size());
+  std::string out(size, '\0');
+  BrotliEncoderCompress(5, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT,
+                        data.size(),
+                        reinterpret_cast<const uint8_t*>(data.data()), &size,
+                        reinterpret_cast<uint8_t*>(&out[0]));
+  out.resize(size);
+  return out;
+}
+#endif
+
+// Answers every request with |page|, encoded as set with Serve() if the
+// client accepts that encoding, paced to |bytes_per_second|.
+class MockPod {
+ public:
+  MockPod(const std::string& page, int64_t bytes_per_second)
+      : page_(page), bytes_per_second_(bytes_per_second) {
+    listener_ = socket(AF_INET, SOCK_STREAM, 0);
+    int reuse = 1;
+    setsockopt(listener_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    if (bind(listener_, reinterpret_cast<sockaddr*>(&address), length) != 0 ||
+        listen(listener_, 4) != 0 ||
+        getsockname(listener_, reinterpret_cast<sockaddr*>(&address),
+                    &length) != 0) {
+      perror("mock pod");
+      exit(1);
+    }
+    port_ = ntohs(address.sin_port);
+    thread_ = std::thread([this]() { Run(); });
+  }
+
+  ~MockPod() {
+    stopping_ = true;
+    shutdown(listener_, SHUT_RDWR);
+    close(listener_);
+    thread_.join();
+  }
+
+  std::string url() const {
+    return "http://127.0.0.1:" + std::to_string(port_);
+  }
+
+  // |encoding| is "identity" or the Content-Encoding of |body|.
+  void Serve(const std::string& encoding, const std::string& body) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    encoding_ = encoding;
+    body_ = std::make_shared<const std::string>(body);
+  }
+
+ private:
+  void Run() {
+    while (!stopping_) {
+      int client = accept(listener_, nullptr, nullptr);
+      if (client < 0) {
+        continue;
+      }
+      Respond(client);
+      close(client);
+    }
+  }
+
+  void Respond(int client) {
+    // Read the headers and the small form body that follows them.
+    std::string request;
+    char buffer[4096];
+    size_t header_end = std::string::npos;
+    size_t content_length = 0;
+    while (header_end == std::string::npos ||
+           request.size() < header_end + 4 + content_length) {
+      ssize_t received = recv(client, buffer, sizeof(buffer), 0);
+      if (received <= 0) {
+        return;
+      }
+      request.append(buffer, received);
+      if (header_end == std::string::npos) {
+        header_end = request.find("\r\n\r\n");
+        const char* found = strcasestr(request.c_str(), "\r\ncontent-length:");
+        if (found != nullptr) {
+          content_length = strtoul(found + 17, nullptr, 10);
+        }
+      }
+    }
+
+    // Serve() runs on the benchmark's thread.
+    std::string encoding;
+    std::shared_ptr<const std::string> encoded;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      encoding = encoding_;
+      encoded = body_;
+    }
+
+    std::string headers = request.substr(0, header_end);
+    const char* accept = strcasestr(headers.c_str(), "\r\naccept-encoding:");
+    bool encode = encoding != "identity" && encoded != nullptr &&
+                  accept != nullptr &&
+                  std::string(accept, strcspn(accept + 2, "\r") + 2)
+                          .find(encoding) != std::string::npos;
+    const std::string& body = encode ? *encoded : page_;
+    std::string response =
+        "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+        "Connection: close\r\nContent-Length: " +
+        std::to_string(body.size()) + "\r\n";
+    if (encode) {
+      response += "Content-Encoding: " + encoding + "\r\n";
+    }
+    response += "\r\n";
+    send(client, response.data(), response.size(), MSG_NOSIGNAL);
+
+    constexpr size_t kChunk = 16 * 1024;
+    Clock::time_point start = Clock::now();
+    for (size_t offset = 0; offset < body.size(); offset += kChunk) {
+      if (bytes_per_second_ > 0) {
+        std::this_thread::sleep_until(
+            start + std::chrono::microseconds(static_cast<int64_t>(
+                        offset * 1e6 / bytes_per_second_)));
+      }
+      size_t length = std::min(kChunk, body.size() - offset);
+      if (send(client, body.data() + offset, length, MSG_NOSIGNAL) < 0) {
+        return;
+      }
+    }
+  }
+
+  const std::string page_;
+  const int64_t bytes_per_second_;
+  int listener_ = -1;
+  int port_ = 0;
+  std::thread thread_;
+  std::atomic<bool> stopping_{false};
+  std::mutex mutex_;
+  // Guarded by mutex_.
+  std::string encoding_ = "identity";
+  std::shared_ptr<const std::string> body_;
+};
+
+struct Result {
+  int64_t wire_bytes = 0;
+  double first_row_ms = 0;
+  double total_ms = 0;
+  size_t held_bytes = 0;
+  size_t rows = 0;
+};
+
+bool FetchBuffered(SyncEngine* engine, Result* result) {
+  Clock::time_point start = Clock::now();
+  std::string body;
+  std::string error;
+  if (!engine->FetchTimeline("discover", &body, &error)) {
+    fprintf(stderr, "fetch failed: %s\n", error.c_str());
+    return false;
+  }
+  JsonReader reader(body);
+  std::string twt;
+  bool ok = reader.ReadObject([&](const std::string& key) {
+    if (key != "twts") {
+      return reader.SkipValue();
+    }
+    return reader.ReadArray([&]() {
+      if (result->rows++ == 0) {
+        result->first_row_ms = MillisecondsSince(start);
+      }
+      return reader.ReadRaw(&twt);
+    });
+  });
+  result->total_ms = MillisecondsSince(start);
+  result->held_bytes = body.size();
+  return ok;
+}
+
+bool FetchStreamed(SyncEngine* engine, Result* result) {
+  Clock::time_point start = Clock::now();
+  TwtStream stream([&](const char* data, size_t size) {
+    if (result->rows++ == 0) {
+      result->first_row_ms = MillisecondsSince(start);
+    }
+    result->held_bytes = std::max(result->held_bytes, size);
+  });
+  std::string error;
+  bool ok = engine->FetchTimeline(
+      "discover",
+      [&stream](const char* data, size_t size) {
+        return stream.Feed(data, size);
+      },
+      &error);
+  result->total_ms = MillisecondsSince(start);
+  if (!ok || !stream.done()) {
+    fprintf(stderr, "fetch failed: %s\n", error.c_str());
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int twts = 5000;
+  int64_t kbps = 2048;
+  int runs = 3;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (strcmp(argv[i], "--twts") == 0) {
+      twts = atoi(argv[i + 1]);
+    } else if (strcmp(argv[i], "--kbps") == 0) {
+      kbps = atoll(argv[i + 1]);
+    } else if (strcmp(argv[i], "--runs") == 0) {
+      runs = std::max(1, atoi(argv[i + 1]));
+    } else {
+      fprintf(stderr, "Usage: %s [--twts N] [--kbps N] [--runs N]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  curl_global_init(CURL_GLOBAL_DEFAULT);
+
+  std::string page = MakeDiscoverPage(twts);
+  std::vector<std::pair<std::string, std::string>> encodings = {
+      {"identity", page},
+      {"gzip", Gzip(page)},
+#ifdef HAVE_BROTLI
+      {"br", Brotli(page)},
+#endif
+  };
+
+  MockPod pod(page, kbps * 1024);
+  SyncEngine engine(pod.url());
+  engine.set_token("benchmark");
+
+  printf("discover page: %d twts, %zu bytes; link: %lld KiB/s; median of %d\n",
+         twts, page.size(), static_cast<long long>(kbps), runs);
+  printf("%-9s %-9s %12s %14s %10s %12s %7s\n", "encoding", "mode",
+         "wire bytes", "first row ms", "total ms", "held bytes", "rows");
+  for (const auto& encoding : encodings) {
+    pod.Serve(encoding.first, encoding.second);
+    for (bool streamed : {false, true}) {
+      std::vector<Result> results(runs);
+      for (Result& result : results) {
+        bool ok = streamed ? FetchStreamed(&engine, &result)
+                           : FetchBuffered(&engine, &result);
+        if (!ok) {
+          return 1;
+        }
+        result.wire_bytes = engine.wire_bytes();
+      }
+      std::sort(results.begin(), results.end(),
+                [](const Result& a, const Result& b) {
+                  return a.first_row_ms < b.first_row_ms;
+                });
+      const Result& median = results[runs / 2];
+      printf("%-9s %-9s %12lld %14.1f %10.1f %12zu %7zu\n",
+             encoding.first.c_str(), streamed ? "streamed" : "buffered",
+             static_cast<long long>(median.wire_bytes), median.first_row_ms,
+             median.total_ms, median.held_bytes, median.rows);
+    }
+  }
+
+  curl_global_cleanup();
+  return 0;
+}
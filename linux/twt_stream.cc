@@ -0,0 +1,123 @@
+#include "twt_stream.h"
+
+#include <utility>
+
+namespace {
+
+// Deeper documents are rejected, as in JsonReader.
+constexpr int kMaxDepth = 256;
+
+// Keys longer than this cannot be "twts" and are not kept.
+constexpr size_t kMaxKeyLength = 8;
+
+}  // namespace
+
+TwtStream::TwtStream(OnTwt on_twt) : on_twt_(std::move(on_twt)) {}
+
+bool TwtStream::Feed(const char* data, size_t size) {
+  if (failed_) {
+    return false;
+  }
+  const char* end = data + size;
+  const char* capture = capturing_ ? data : nullptr;
+  for (const char* p = data; p < end; p++) {
+    char c = *p;
+    if (in_string_) {
+      // Skip the run up to the next quote or escape in one go.
+      const char* run = p;
+      while (p < end && *p != '"' && *p != '\\' && !escape_) {
+        p++;
+      }
+      if (reading_key_ && key_.size() <= kMaxKeyLength) {
+        key_.append(run, p - run);
+      }
+      if (p == end) {
+        break;
+      }
+      c = *p;
+      if (escape_) {
+        escape_ = false;
+      } else if (c == '\\') {
+        escape_ = true;
+      } else {
+        in_string_ = false;
+        reading_key_ = false;
+      }
+      continue;
+    }
+
+    switch (c) {
+      case '"':
+        in_string_ = true;
+        if (depth_ == 1 && expect_key_) {
+          expect_key_ = false;
+          reading_key_ = true;
+          key_.clear();
+        }
+        break;
+      case ':':
+        if (depth_ == 1) {
+          twts_member_ = key_ == "twts";
+        }
+        break;
+      case ',':
+        if (depth_ == 1) {
+          expect_key_ = true;
+          twts_member_ = false;
+        }
+        break;
+      case '{':
+      case '[':
+        if (done_ || (depth_ == 0 && c != '{') || depth_ >= kMaxDepth) {
+          failed_ = true;
+          return false;
+        }
+        depth_++;
+        if (depth_ == 1) {
+          expect_key_ = true;
+        } else if (depth_ == 2 && c == '[' && twts_member_) {
+          in_twts_ = true;
+        } else if (depth_ == 3 && in_twts_) {
+          capturing_ = true;
+          capture = p;
+        }
+        break;
+      case '}':
+      case ']':
+        if (depth_ == 0) {
+          failed_ = true;
+          return false;
+        }
+        if (depth_ == 3 && capturing_) {
+          twt_.append(capture, p + 1 - capture);
+          on_twt_(twt_.data(), twt_.size());
+          twt_.clear();
+          twt_count_++;
+          capturing_ = false;
+          capture = nullptr;
+        } else if (depth_ == 2) {
+          in_twts_ = false;
+        }
+        if (--depth_ == 0) {
+          done_ = true;
+        }
+        break;
+      case ' ':
+      case '\t':
+      case '\n':
+      case '\r':
+        break;
+      default:
+        // Numbers and literals; only the root has to be an object.
+        if (depth_ == 0) {
+          failed_ = true;
+          return false;
+        }
+        break;
+    }
+  }
+  if (capturing_) {
+    twt_.append(capture, end - capture);
+  }
+  return true;
+}
@@ -0,0 +1,55 @@
+#ifndef FLUTTER_TWT_STREAM_H_
+#define FLUTTER_TWT_STREAM_H_
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+// Splits a timeline response ({"twts": [...], ...}) into the JSON text of
+// each twt while the response is still arriving, so the first rows can be
+// shown before the last bytes are received and the whole body is never held
+// in memory.
+//
+// Only the structure is tracked, enough to find where each element of the
+// "twts" array starts and ends; the elements themselves are checked by
+// whoever decodes them.
+class TwtStream {
+ public:
+  // Called with the source text of each twt, in order.
+  using OnTwt = std::function<void(const char* data, size_t size)>;
+
+  explicit TwtStream(OnTwt on_twt);
+
+  // Feeds the next |size| bytes of the response. Returns false once the
+  // input cannot be a timeline response; later calls keep failing.
+  bool Feed(const char* data, size_t size);
+
+  // True if the response fed so far is complete.
+  bool done() const { return done_; }
+
+  // Number of twts passed to the callback.
+  size_t twt_count() const { return twt_count_; }
+
+ private:
+  OnTwt on_twt_;
+
+  int depth_ = 0;
+  bool in_string_ = false;
+  bool escape_ = false;
+  // The root object's next string is a key, and is being read into key_.
+  bool expect_key_ = false;
+  bool reading_key_ = false;
+  std::string key_;
+  // The root object's current member is "twts", and its array is open.
+  bool twts_member_ = false;
+  bool in_twts_ = false;
+  // A twt is open; its text so far is in twt_ plus the current chunk from
+  // the offset remembered in Feed().
+  bool capturing_ = false;
+  std::string twt_;
+  bool done_ = false;
+  bool failed_ = false;
+  size_t twt_count_ = 0;
+};
+
+#endif  // FLUTTER_TWT_STREAM_H_